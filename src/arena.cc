@@ -0,0 +1,87 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <iostream>
+#include "arena.h"
+
+static inline uintptr_t align_up(const char *p, size_t align) {
+    return (reinterpret_cast<uintptr_t>(p) + align - 1) & ~(uintptr_t) (align - 1);
+}
+
+Arena::Arena(size_t initial_chunk_size, size_t max_chunk_size)
+: chunk_size_     {initial_chunk_size}
+, max_chunk_size_ {max_chunk_size}
+{}
+
+Arena::~Arena() {
+    for (const chunk_t &chunk : chunks_) {
+        free(chunk.base);
+    }
+}
+
+/**
+ * @brief Move on to the next chunk that is large enough to hold `size` bytes.
+ * Chunks left over from before the last reset are reused before asking the system for more.
+ * 
+ * @param size 
+ */
+void Arena::grow(size_t size) {
+
+    size_t next = (cursor_ == nullptr) ? current_ : current_ + 1;
+    while (next < chunks_.size() && chunks_[next].size < size) {
+        next++;
+    }
+
+    if (next == chunks_.size()) {
+        size_t chunk_size = chunk_size_;
+        while (chunk_size < size) {
+            chunk_size <<= 1;
+        }
+
+        char *base = static_cast<char *>(malloc(chunk_size));
+        if (base == NULL) {
+            FATAL(": Out of memory while growing the arena by " << chunk_size << " bytes");
+        }
+        chunks_.push_back({base, chunk_size});
+        num_chunk_allocations_++;
+
+        if (chunk_size_ < max_chunk_size_) {
+            chunk_size_ <<= 1;
+        }
+    }
+
+    current_ = next;
+    cursor_  = chunks_[current_].base;
+    end_     = chunks_[current_].base + chunks_[current_].size;
+}
+
+/**
+ * @brief Carve `size` bytes aligned to `align` out of the current chunk
+ * 
+ * @param size 
+ * @param align Must be a power of two
+ * @return void* 
+ */
+void *Arena::allocate(size_t size, size_t align) {
+    uintptr_t p = align_up(cursor_, align);
+
+    if (cursor_ == nullptr || p + size > reinterpret_cast<uintptr_t>(end_)) {
+        grow(size + align);
+        p = align_up(cursor_, align);
+    }
+
+    cursor_ = reinterpret_cast<char *>(p + size);
+    num_allocations_++;
+    num_bytes_ += size;
+    return reinterpret_cast<void *>(p);
+}
+
+/**
+ * @brief Forget every allocation in O(1). The chunks are kept for reuse.
+ */
+void Arena::reset() {
+    current_         = 0;
+    cursor_          = nullptr;
+    end_             = nullptr;
+    num_allocations_ = 0;
+    num_bytes_       = 0;
+}
@@ -0,0 +1,68 @@
+#ifndef __ARENA_H__
+#define __ARENA_H__
+
+#include <vector>
+#include <cstddef>
+#include <new>
+#include <utility>
+#include "types.h"
+
+/**
+ * @brief A bump pointer allocator that hands out memory from a list of chunks.
+ * Individual allocations are never freed. Instead, the whole arena is rewound
+ * in O(1) by reset(), and the chunks are reused by the next simulation.
+ * Chunks start small and double in size, so an arena that is barely used costs almost nothing.
+ * 
+ * Objects placed in the arena are not destroyed on reset(). If they own memory
+ * outside of the arena, their owner has to run their destructors first, as
+ * System::destroy() does.
+ */
+class Arena {
+private:
+    struct chunk_t {
+        char   *base;
+        size_t  size;
+    };
+
+    std::vector<chunk_t> chunks_;
+    size_t current_{0};
+    size_t chunk_size_;
+    size_t max_chunk_size_;
+    char  *cursor_{nullptr};
+    char  *end_{nullptr};
+
+    /* Allocation counters since the last reset */
+    ulong num_allocations_{0}, num_bytes_{0};
+
+    /* Number of times the arena had to go to the system allocator */
+    ulong num_chunk_allocations_{0};
+
+    void grow(size_t size);
+
+public:
+    explicit Arena(size_t initial_chunk_size = 4096, size_t max_chunk_size = 1 << 20);
+    ~Arena();
+
+    Arena(const Arena &) = delete;
+    Arena &operator=(const Arena &) = delete;
+
+    void *allocate(size_t size, size_t align = alignof(std::max_align_t));
+    void reset();
+
+    template <typename T>
+    T *allocate_array(size_t n) {
+        return static_cast<T *>(allocate(n * sizeof(T), alignof(T)));
+    }
+
+    template <typename T, typename... Args>
+    T *create(Args&&... args) {
+        return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+    }
+
+    ulong get_num_allocations() const       { return num_allocations_; }
+    ulong get_num_bytes() const             { return num_bytes_; }
+    ulong get_num_chunks() const            { return chunks_.size(); }
+    ulong get_num_chunk_allocations() const { return num_chunk_allocations_; }
+};
+
+#endif /* __ARENA_H__ */
@@ -1,24 +1,175 @@
+#include <iostream>
 #include "bus.h"
 
-Bus::Bus()
+Bus::Bus(ulong num_cores, const bus_config_t &config)
 : Port<bus_transaction_t> ()
-{}
+, config_ {config}
+{
+    stats_.core_bytes.resize(num_cores, 0);
+}
+
+void Bus::clear_stats() {
+    ulong num_cores = stats_.core_bytes.size();
+    stats_ = bus_stats_t();
+    stats_.core_bytes.resize(num_cores, 0);
+}
 
 /**
- * @brief Receive a bus transaction from a requesting core 
- * and forward it to all receiving cores
+ * @brief The width of an access is implied by the alignment of its address,
+ * up to the width of a word. e.g. 0x...6 is a 2 byte access.
+ * 
+ * @param addr 
+ * @return ulong 
+ */
+ulong Bus::access_width(ulong addr) const {
+    ulong alignment = addr & (~addr + 1);
+    if (alignment == 0 || alignment > config_.word_bytes) {
+        return config_.word_bytes;
+    }
+    return alignment;
+}
+
+void Bus::account(ulong core, bus_traffic_t &traffic, ulong command_bytes, ulong data_bytes, ulong time) {
+    traffic.count++;
+    traffic.command_bytes += command_bytes;
+    traffic.data_bytes    += data_bytes;
+    stats_.core_bytes[core] += command_bytes + data_bytes;
+    account_interval(time, command_bytes + data_bytes);
+}
+
+/**
+ * @brief Add the bytes of a transaction to the interval of the time it was issued at.
+ * The cores have their own clocks, so a transaction can land in an earlier interval than the one before it.
+ */
+void Bus::account_interval(ulong time, ulong bytes) {
+    if (config_.interval == 0) {
+        return;
+    }
+    ulong interval = time / config_.interval;
+    if (interval >= stats_.interval_bytes.size()) {
+        stats_.interval_bytes.resize(interval + 1, 0);
+    }
+    stats_.interval_bytes[interval] += bytes;
+}
+
+/**
+ * @brief Connect a cache to the snoop fan-out of this bus
+ * 
+ * @param cache 
+ * @param core The ID of the core that owns the cache
+ */
+void Bus::attach(Port<bus_transaction_t> *cache, ulong core) {
+    Port<bus_transaction_t>::connect(cache);
+    cores_.push_back(core);
+}
+
+/**
+ * @brief Account for the request phase of a transaction
  * 
  * @param trans 
+ * @return true if the transaction has to be snooped by the other caches
  */
-void Bus::receive(const bus_transaction_t &trans) {
+bool Bus::post(bus_transaction_t &trans) {
 
     ulong requesting_core = trans.processor_id;
-    for (ulong core = 0; core < Port<bus_transaction_t>::get_num_ports(); core++) {
-        /* Forward the bus transaction to all receiving cores */
-        if (core != requesting_core) {
-            Port<bus_transaction_t>::send(core, trans);
+    bool snooped = false;
+
+    for (bus_signal_e signal : trans.bus_signals) {
+        switch (signal) {
+            case bus_signal_e::BusRd        : account(requesting_core, stats_.busrd, config_.addr_bytes, 0, trans.time);
+                                              snooped = true;
+                                              break;
+
+            case bus_signal_e::BusRdX       : account(requesting_core, stats_.busrdx, config_.addr_bytes, 0, trans.time);
+                                              snooped = true;
+                                              break;
+
+            case bus_signal_e::BusUpd       : account(requesting_core, stats_.busupd, config_.addr_bytes, access_width(trans.addr), trans.time);
+                                              snooped = true;
+                                              break;
+
+            case bus_signal_e::WriteBack    : account(requesting_core, stats_.writeback, config_.addr_bytes, config_.block_bytes, trans.time);
+                                              if (memory_ != NULL) {
+                                                  memory_->access(trans.addr, trans.time, true);
+                                              }
+                                              break;
+
+            default                         : FATAL("Encountered invalid signal " << signal << " on the bus");
+        }
+    }
+    return snooped;
+}
+
+/**
+ * @brief Forward the transaction to every attached cache except the requesting one
+ * 
+ * @param trans 
+ */
+void Bus::snoop(bus_transaction_t &trans) {
+
+    ulong requesting_core = trans.processor_id;
+    if (profiler_ != NULL) {
+        profiler_->count_fan_out(requesting_core);
+    }
+    for (ulong port = 0; port < Port<bus_transaction_t>::get_num_ports(); port++) {
+        if (cores_[port] != requesting_core) {
+            if (profiler_ != NULL) {
+                profiler_->count_snoop(requesting_core, cores_[port]);
+            }
+            ulong num_flushes = trans.num_flushes;
+            Port<bus_transaction_t>::send(port, trans);
+            if (trans.num_flushes != num_flushes) {
+                account(cores_[port], stats_.flush, 0, config_.block_bytes, trans.time);
+                /* Like the writeback counters of the caches, a flush updates memory */
+                if (memory_ != NULL) {
+                    memory_->access(trans.addr, trans.time, true);
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief Account for the data phase of a snooped transaction.
+ * The block is supplied by memory unless a cache flushed it.
+ * 
+ * @param trans 
+ * @return true if memory supplied the block
+ */
+bool Bus::reply(bus_transaction_t &trans) {
+
+    if (trans.num_flushes != 0) {
+        return false;
+    }
+
+    bool from_memory = false;
+    for (bus_signal_e signal : trans.bus_signals) {
+        if (signal == bus_signal_e::BusRd || signal == bus_signal_e::BusRdX) {
+            stats_.core_bytes[trans.processor_id] += config_.block_bytes;
+            (signal == bus_signal_e::BusRd ? stats_.busrd : stats_.busrdx).data_bytes += config_.block_bytes;
+            account_interval(trans.time, config_.block_bytes);
+            from_memory = true;
         }
     }
+    if (from_memory && memory_ != NULL) {
+        memory_->access(trans.addr, trans.time, false);
+    }
+    return from_memory;
+}
+
+/**
+ * @brief Receive a bus transaction from a requesting core 
+ * and forward it to all receiving cores
+ * 
+ * @param trans 
+ */
+void Bus::receive(bus_transaction_t &trans) {
+
+    /* Writebacks go straight to memory */
+    if (post(trans)) {
+        snoop(trans);
+        reply(trans);
+    }
 }
 
 /**
@@ -30,10 +181,75 @@ void Bus::receive(const bus_transaction_t &trans) {
 void Bus::respond(bus_transaction_t &trans) {
 
     ulong requesting_core = trans.processor_id;
-    for (ulong core = 0; core < Port<bus_transaction_t>::get_num_ports(); core++) {
+    for (ulong port = 0; port < Port<bus_transaction_t>::get_num_ports(); port++) {
         /* Find out whether other caches have the block */
-        if (core != requesting_core) {
-            Port<bus_transaction_t>::request(core, trans);
+        if (cores_[port] != requesting_core) {
+            if (profiler_ != NULL) {
+                profiler_->count_query(cores_[port]);
+            }
+            Port<bus_transaction_t>::request(port, trans);
         }
     }
 }
+
+#define TRACE_TRAFFIC(s, t) \
+    do { \
+        printf("%-12s %12lu %14lu %14lu %14lu\n", s, (t).count, (t).command_bytes, (t).data_bytes, (t).bytes()); \
+    } while(0)
+
+bus_stats_t &bus_stats_t::operator+= (const bus_stats_t &other) {
+    busrd     += other.busrd;
+    busrdx    += other.busrdx;
+    busupd    += other.busupd;
+    flush     += other.flush;
+    writeback += other.writeback;
+
+    if (core_bytes.size() < other.core_bytes.size()) {
+        core_bytes.resize(other.core_bytes.size(), 0);
+    }
+    for (ulong core = 0; core < other.core_bytes.size(); core++) {
+        core_bytes[core] += other.core_bytes[core];
+    }
+
+    if (interval_bytes.size() < other.interval_bytes.size()) {
+        interval_bytes.resize(other.interval_bytes.size(), 0);
+    }
+    for (ulong interval = 0; interval < other.interval_bytes.size(); interval++) {
+        interval_bytes[interval] += other.interval_bytes[interval];
+    }
+    return *this;
+}
+
+void print_bus_stats(const char *title, const bus_stats_t &stats) {
+
+    printf("============ %s ============\n", title);
+    printf("%-12s %12s %14s %14s %14s\n", "transaction", "count", "command", "data", "total");
+    TRACE_TRAFFIC("BusRd",      stats.busrd);
+    TRACE_TRAFFIC("BusRdX",     stats.busrdx);
+    TRACE_TRAFFIC("BusUpd",     stats.busupd);
+    TRACE_TRAFFIC("Flush",      stats.flush);
+    TRACE_TRAFFIC("WriteBack",  stats.writeback);
+
+    for (ulong core = 0; core < stats.core_bytes.size(); core++) {
+        printf("core %-7lu %57lu\n", core, stats.core_bytes[core]);
+    }
+    printf("%-12s %57lu\n", "total", stats.bytes());
+}
+
+/**
+ * @brief Print the bytes on the bus per interval of `interval` cycles of the clock of the timing model
+ */
+void print_bus_intervals(const char *clock, ulong interval, const bus_stats_t &stats) {
+
+    printf("============ Bus bandwidth per interval (%lu %s) ============\n", interval, clock);
+    printf("%-12s %14s %14s %14s\n", "interval", "start cycle", "bytes", "bytes/cycle");
+
+    /* The time keeps running through a warm-up, skip the intervals it leaves empty */
+    ulong first = 0;
+    while (first < stats.interval_bytes.size() && stats.interval_bytes[first] == 0) {
+        first++;
+    }
+    for (ulong i = first; i < stats.interval_bytes.size(); i++) {
+        printf("%-12lu %14lu %14lu %14.3lf\n", i, i * interval, stats.interval_bytes[i], (double) stats.interval_bytes[i] / interval);
+    }
+}
@@ -2,15 +2,96 @@
 #define __BUS_H__
 
 #include <vector>
+#include "dram.h"
+#include "profile.h"
 #include "cache.h"
 #include "port.h"
 
+/**
+ * @brief Sizes used to turn bus transactions into bytes
+ */
+struct bus_config_t {
+    ulong addr_bytes{8};    /* Command/address phase of every transaction */
+    ulong word_bytes{8};    /* Widest word that a BusUpd can carry */
+    ulong block_bytes{64};  /* A flush, writeback or data reply carries a full block */
+
+    /* Cycles per interval of the bandwidth breakdown, 0 without a timing model */
+    ulong interval{0};
+};
+
+/**
+ * @brief Traffic counters of one kind of bus transaction
+ */
+struct bus_traffic_t {
+    ulong count{0}, command_bytes{0}, data_bytes{0};
+
+    ulong bytes() const { return command_bytes + data_bytes; }
+
+    bus_traffic_t &operator+= (const bus_traffic_t &other) {
+        count         += other.count;
+        command_bytes += other.command_bytes;
+        data_bytes    += other.data_bytes;
+        return *this;
+    }
+};
+
+/**
+ * @brief A snapshot of the traffic seen by the bus, per transaction type and per core
+ */
+struct bus_stats_t {
+    bus_traffic_t busrd, busrdx, busupd, flush, writeback;
+
+    /* Bytes driven onto the bus by each core (requests, flushes and writebacks) */
+    std::vector<ulong> core_bytes;
+
+    /* Bytes per interval of the time of the requesting cores, with a timing model */
+    std::vector<ulong> interval_bytes;
+
+    ulong bytes() const {
+        return busrd.bytes() + busrdx.bytes() + busupd.bytes() + flush.bytes() + writeback.bytes();
+    }
+
+    bus_stats_t &operator+= (const bus_stats_t &other);
+};
+
+void print_bus_stats(const char *title, const bus_stats_t &stats);
+void print_bus_intervals(const char *clock, ulong interval, const bus_stats_t &stats);
+
 class Bus : public Port<bus_transaction_t>{
 
+private:
+    bus_config_t config_;
+    bus_stats_t stats_;
+
+    /* ID of the core behind each port */
+    std::vector<ulong> cores_;
+
+    /* Optional main memory model behind the bus */
+    Dram *memory_{nullptr};
+
+    /* Optional profiler, counts the snoop fan-out */
+    Profiler *profiler_{nullptr};
+
+    ulong access_width(ulong addr) const;
+    void account(ulong core, bus_traffic_t &traffic, ulong command_bytes, ulong data_bytes, ulong time);
+    void account_interval(ulong time, ulong bytes);
+
 public:
-    Bus();
-    void receive(const bus_transaction_t &trans) override;
+    Bus(ulong num_cores, const bus_config_t &config);
+    void attach(Port<bus_transaction_t> *cache, ulong core);
+    void set_memory(Dram *memory) { memory_ = memory; }
+    void set_profiler(Profiler *profiler) { profiler_ = profiler; }
+
+    /* The three phases of a transaction, for interconnects that span several buses */
+    bool post(bus_transaction_t &trans);
+    void snoop(bus_transaction_t &trans);
+    bool reply(bus_transaction_t &trans);
+
+    void receive(bus_transaction_t &trans) override;
     void respond(bus_transaction_t &trans) override;
+
+    const bus_stats_t &get_stats() const { return stats_; }
+    void clear_stats();
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -2,9 +2,22 @@
 #include <assert.h>
 #include <algorithm>
 #include <cmath>
+#include <string.h>
 #include "cache.h"
+#include "cache_block_msi.h"
+#include "cache_block_dragon.h"
 #include "factory.h"
 
+/**
+ * @brief Register the protocols of the simulator with the object factory.
+ * The first cache does it, static initializers would be left out of programs linking libsmpcache.a.
+ */
+static bool register_protocols() {
+   Factory::get_instance()->register_class("MSI",    FACTORY_ENTRY(CacheBlockMSI));
+   Factory::get_instance()->register_class("Dragon", FACTORY_ENTRY(CacheBlockDragon));
+   return true;
+}
+
 static std::string to_string(const protocol_e &p) {
    std::stringstream ss;
    ss << p;
@@ -13,48 +26,145 @@ static std::string to_string(const protocol_e &p) {
 }
 
 
-Cache::Cache(uint id, ulong size, ulong assoc, ulong block_size, protocol_e protocol)
+/* Largest prime number no greater than n, or 1 */
+static ulong largest_prime(ulong n) {
+   for (; n > 2; n--) {
+      bool prime = true;
+      for (ulong d = 2; d * d <= n && prime; d++) {
+         prime = (n % d != 0);
+      }
+      if (prime) {
+         return n;
+      }
+   }
+   return std::max(n, 1UL);
+}
+
+Cache::Cache(uint id, ulong size, ulong assoc, ulong block_size, protocol_e protocol, Arena &arena, storage_e storage, index_e index)
 : Port<bus_transaction_t>  ()
+, arena_       {arena}
+, storage_     {storage}
+, index_       {index}
 , id_          {id}
 , size_        {size}
 , assoc_       {assoc}
 , block_size_  {block_size}
 , protocol_    {to_string(protocol)}
 {
+   static const bool registered = register_protocols();
+   (void) registered;
+
+   if (block_size_ == 0 || (block_size_ & (block_size_ - 1)) != 0) {
+      FATAL(": The block size must be a power of two");
+   }
+   if (assoc_ == 0 || size_ < block_size_ * assoc_ || size_ % (block_size_ * assoc_) != 0) {
+      FATAL(": The cache size must be a multiple of the block size times the associativity");
+   }
+
+   /* The number of sets need not be a power of two, the index bits cover all of them */
    num_sets_               = size_ / (block_size_ * assoc_);
    num_blocks_             = size_ / block_size_;
-   num_index_bits_         = log2(num_sets_);
    num_block_offset_bits_  = log2(block_size_);
-   tag_mask_               = (1 << num_index_bits_) - 1;
-
-   cache_.resize(num_sets_);
-   for (uint i = 0; i < num_sets_; i++){
-      cache_[i].resize(assoc_);
+   while ((1UL << num_index_bits_) < num_sets_) {
+      num_index_bits_++;
    }
-   
-   for(uint i = 0; i < num_sets_; i++) {
-      for(uint j = 0; j < assoc_; j++) {
-         /* The desired cache block depends on the protocol */
-         cache_[i][j] = FACTORY_CREATE(protocol_);
-         cache_[i][j]->invalidate();
+   tag_mask_               = (1UL << num_index_bits_) - 1;
+   pow2_sets_              = ((num_sets_ & (num_sets_ - 1)) == 0);
+   num_prime_sets_         = largest_prime(num_sets_);
+   plain_index_            = (index_ == index_e::Modulo && pow2_sets_);
+
+   tag_match_     = select_tag_match(assoc_);
+   victim_match_  = select_tag_match();
+
+   select_access_fn();
+   sets_ = arena_.allocate_array<set_t>(num_sets_);
+   for(ulong i = 0; i < num_sets_; i++) {
+      new (&sets_[i]) set_t();
+   }
+
+   /* A sparse cache materializes its sets on first touch */
+   if (storage_ == storage_e::Dense) {
+      for(ulong i = 0; i < num_sets_; i++) {
+         touch_set(i);
       }
-   } 
+   }
 }
 
-Cache::~Cache() {
-   for(uint i = 0; i < num_sets_; i++) {
-      for(uint j = 0; j < assoc_; j++) {
-         delete cache_[i][j];
-      }
-   } 
+/**
+ * @brief Return the set at `index`, allocating its tags and blocks if this is the first time it is used
+ * 
+ * @param index 
+ * @return set_t& 
+ */
+Cache::set_t &Cache::touch_set(ulong index) {
+
+   set_t &set = sets_[index];
+   if (set.tags != NULL) {
+      return set;
+   }
+
+   set.tags   = arena_.allocate_array<ulong>(assoc_);
+   set.blocks = arena_.allocate_array<CacheBlock *>(assoc_);
+
+   for(ulong j = 0; j < assoc_; j++) {
+      set.tags[j] = INVALID_TAG;
+      /* The desired cache block depends on the protocol */
+      set.blocks[j] = FACTORY_CREATE(protocol_, arena_);
+      set.blocks[j]->set_stats(&coherence_stats_);
+      set.blocks[j]->invalidate();
+   }
+
+   num_sets_touched_++;
+   return set;
 }
 
 ulong Cache::calc_tag(ulong addr) {
    return (addr >> num_block_offset_bits_);
 }
 
-ulong Cache::calc_index(ulong addr) {
-   return ((addr >> num_block_offset_bits_) & tag_mask_);
+/* Bring a hash of num_index_bits_ bits within the sets */
+ulong Cache::reduce_index(ulong hash) {
+   return pow2_sets_ ? (hash & tag_mask_) : (hash % num_sets_);
+}
+
+/**
+ * @brief The set of a block, for the way `way` with a skewed index.
+ * calc_index() handles plain modulo indexing over a power of two sets inline.
+ */
+ulong Cache::calc_hashed_index(ulong addr, ulong way) {
+
+   ulong block = addr >> num_block_offset_bits_;
+
+   switch (index_) {
+      case index_e::Modulo:
+         return pow2_sets_ ? (block & tag_mask_) : (block % num_sets_);
+
+      case index_e::PrimeModulo:
+         return block % num_prime_sets_;
+
+      case index_e::XorFold: {
+         ulong hash = 0;
+         for (; block != 0 && num_index_bits_ != 0; block >>= num_index_bits_) {
+            hash ^= block & tag_mask_;
+         }
+         return reduce_index(hash);
+      }
+
+      case index_e::Skewed: {
+         if (num_index_bits_ == 0) {
+            return 0;
+         }
+         /* XOR the index bits with the next field of the address, rotated by a different amount in every way */
+         ulong low    = block & tag_mask_;
+         ulong high   = (block >> num_index_bits_) & tag_mask_;
+         ulong rotate = way % num_index_bits_;
+         if (rotate != 0) {
+            high = ((high << rotate) | (high >> (num_index_bits_ - rotate))) & tag_mask_;
+         }
+         return reduce_index(low ^ high);
+      }
+   }
+   return 0;
 }
 
 ulong Cache::calc_addr_for_tag(ulong tag) {
@@ -63,13 +173,60 @@ ulong Cache::calc_addr_for_tag(ulong tag) {
 
 /******************************************************************/
 
+/**
+ * @brief The protocols we know about get a specialized access path, anything else goes through the vtable.
+ * Profiling has a path of its own, so that the unprofiled one does not even test for it.
+ */
+void Cache::select_access_fn() {
+   bool profile = (profiler_ != NULL);
+
+   if (protocol_ == "MSI") {
+      access_fn_ = profile ? &Cache::access<CacheBlockMSI, true> : &Cache::access<CacheBlockMSI, false>;
+   } else if (protocol_ == "Dragon") {
+      access_fn_ = profile ? &Cache::access<CacheBlockDragon, true> : &Cache::access<CacheBlockDragon, false>;
+   } else {
+      access_fn_ = profile ? &Cache::access<CacheBlock, true> : &Cache::access<CacheBlock, false>;
+   }
+}
+
+void Cache::set_profiler(Profiler *profiler) {
+   profiler_ = profiler;
+   select_access_fn();
+}
+
+/**
+ * @brief Run the requesting core's state machine of a BLOCK without going through the vtable,
+ * so that the compiler can inline it into access<BLOCK>()
+ */
+template <typename BLOCK>
+static inline bus_signal_t transition(CacheBlock *block, op_e op, bool copies_exist) {
+   return static_cast<BLOCK *>(block)->BLOCK::next_state(op, copies_exist);
+}
+
+/* The generic version for protocols without a specialized access path */
+template <>
+inline bus_signal_t transition<CacheBlock>(CacheBlock *block, op_e op, bool copies_exist) {
+   return block->next_state(op, copies_exist);
+}
+
 /**
  * @brief Entry point to the memory hierarchy
  * 
+ * @tparam BLOCK The type of the blocks of this cache
+ * @tparam PROFILE Whether to time the phases of the access
  * @param addr 
- * @param op R/W
+ * @param op R/W/atomic/fence
  */
-void Cache::Access(ulong addr, op_e op) {
+template <typename BLOCK, bool PROFILE>
+void Cache::access(ulong addr, op_e op) {
+
+   /* A fence does not touch a block */
+   if (op == op_e::PrFence) {
+      fence();
+      return;
+   }
+
+   ulong phase_start = PROFILE ? profiler_->begin_access() : 0;
 
    current_cycle_++;
 
@@ -80,12 +237,42 @@ void Cache::Access(ulong addr, op_e op) {
       num_writes_++;
    } else if (operation == op_e::PrRd) {
       num_reads_++;
+   } else if (operation == op_e::PrAtomic) {
+      num_atomics_++;
    }
 
    CacheBlock *block = find_block(addr);
+   uint8_t flags = 0;
+
+   /* A conflict miss may still find its block in the victim cache */
+   if (block == NULL && num_victim_entries_ > 0) {
+      block = recover_victim(addr);
+      flags = (block != NULL) ? OUTCOME_VICTIM_HIT : 0;
+   }
+
+   if (PROFILE) {
+      phase_start = profiler_->lap(phase_e::Lookup, phase_start);
+   }
 
+   /* The prefetcher trains on misses, and on the first demand for a prefetched block */
+   bool trigger = (block == NULL);
+   if (block != NULL && block->is_prefetched()) {
+      num_useful_prefetches_++;
+      prefetch_lead_ += current_cycle_ - block->get_seq();
+      block->set_prefetched(false);
+      trigger = true;
+      flags |= OUTCOME_PREFETCH_HIT;
+   }
+
+   state_e state_before = state_e::INVALID;
+
+   /* Hit */
+   if (block != NULL) {
+      flags |= OUTCOME_HIT;
+      state_before = block->get_state();
+   }
    /* Miss */
-   if(block == NULL) {
+   else {
 
       if (operation == op_e::PrWr) {
          num_write_misses_++;
@@ -93,37 +280,243 @@ void Cache::Access(ulong addr, op_e op) {
       } else if (operation == op_e::PrRd) {
          num_read_misses_++;
          operation = op_e::PrRdMiss;
+      } else if (operation == op_e::PrAtomic) {
+         num_atomic_misses_++;
+         operation = op_e::PrAtomicMiss;
       }
       block = fill_block(addr); 
+
+      if (PROFILE) {
+         phase_start = profiler_->lap(phase_e::Fill, phase_start);
+      }
    }
 
    update_LRU(block);
 
    bus_transaction_t requesting_core_trans (id_, addr);
+   requesting_core_trans.cycle = current_cycle_;
+   requesting_core_trans.time  = local_time();
 
    /* Find out whether other caches have the block */
    Port<bus_transaction_t>::request(requesting_core_trans);
 
+   if (PROFILE) {
+      phase_start = profiler_->lap(phase_e::Request, phase_start);
+   }
+
    /* A state transition could result in one or more bus signals */
-   requesting_core_trans.bus_signals = block->next_state(operation, requesting_core_trans.copies_exist);
+   requesting_core_trans.bus_signals = transition<BLOCK>(block, operation, requesting_core_trans.copies_exist);
+
+   if (PROFILE) {
+      phase_start = profiler_->lap(phase_e::Transition, phase_start);
+   }
 
    /* Post the transaction on the bus */
    Port<bus_transaction_t>::send(requesting_core_trans);
+
+   if (requesting_core_trans.bus_signals.empty()) {
+      last_service_ = service_e::Hit;
+   } else if (flags & OUTCOME_HIT) {
+      last_service_ = service_e::Upgrade;
+   } else if (requesting_core_trans.num_flushes > 0 || requesting_core_trans.num_interventions > 0) {
+      last_service_ = service_e::Remote;
+   } else {
+      last_service_ = service_e::Memory;
+   }
+
+   if (op == op_e::PrAtomic) {
+      num_atomic_bus_transactions_ += requesting_core_trans.bus_signals.size();
+      num_atomic_invalidations_    += requesting_core_trans.num_invalidations;
+      num_atomic_flushes_          += requesting_core_trans.num_flushes;
+   }
+
+   if (PROFILE) {
+      phase_start = profiler_->lap(phase_e::Snoop, phase_start);
+   }
+
+   if (outcomes_ != NULL) {
+      record_outcome(addr, op, flags, state_before, block, requesting_core_trans);
+   }
+
+   if (prefetcher_ != NULL) {
+      prefetch(addr, trigger);
+   }
+
+   if (PROFILE) {
+      profiler_->lap(phase_e::Bookkeeping, phase_start);
+   }
+}
+
+/**
+ * @brief Perform an access only if it involves no other cache: a hit that needs no bus
+ * signal whatever the other caches hold, with nothing else observing the access.
+ * The cache ends up exactly as Access() would have left it.
+ * Otherwise the cache is left untouched, and the access has to go through Access().
+ * 
+ * Caches can run their local accesses concurrently, since they only touch their own state.
+ * 
+ * @return whether the access was performed
+ */
+bool Cache::access_local(ulong addr, op_e op) {
+
+   /* The prefetcher, the outcome stream and the profiler are shared or can issue transactions */
+   if (op == op_e::PrFence || prefetcher_ != NULL || outcomes_ != NULL || profiler_ != NULL) {
+      return false;
+   }
+
+   CacheBlock *block = find_block(addr);
+   if (block == NULL || !block->is_silent(op)) {
+      return false;
+   }
+
+   current_cycle_++;
+   if (op == op_e::PrWr) {
+      num_writes_++;
+   } else if (op == op_e::PrRd) {
+      num_reads_++;
+   } else if (op == op_e::PrAtomic) {
+      num_atomics_++;
+   }
+
+   update_LRU(block);
+   block->next_state(op, false);
+   return true;
+}
+
+/**
+ * @brief Append the outcome of a demand access to the outcome stream
+ * 
+ * @param flags OUTCOME_* flags known by the access path. Evictions are added here
+ * @param state_before State of the block before the access, INVALID on a miss
+ * @param block The block after the access
+ * @param trans The transaction of the requesting core, after the other caches snooped it
+ */
+void Cache::record_outcome(ulong addr, op_e op, uint8_t flags, state_e state_before, CacheBlock *block, const bus_transaction_t &trans) {
+
+   outcome_record_t record;
+   memset(&record, 0, sizeof(record));
+
+   if (!(flags & OUTCOME_HIT) && evicted_) {
+      flags |= OUTCOME_EVICTION;
+      flags |= evicted_dirty_ ? OUTCOME_WRITE_BACK : 0;
+      record.victim_addr = evicted_addr_;
+   }
+
+   record.addr                = addr;
+   record.core                = id_;
+   record.op                  = static_cast<uint8_t>(op);
+   record.flags               = flags;
+   record.state_before        = static_cast<uint8_t>(state_before);
+   record.state_after         = static_cast<uint8_t>(block->get_state());
+   record.num_invalidations   = std::min<ulong>(trans.num_invalidations, 255);
+   record.num_interventions   = std::min<ulong>(trans.num_interventions, 255);
+   record.num_flushes         = std::min<ulong>(trans.num_flushes, 255);
+
+   for (bus_signal_e signal : trans.bus_signals) {
+      record.signals |= 1 << static_cast<uint8_t>(signal);
+   }
+
+   outcomes_->append(record);
+}
+
+/**
+ * @brief A fence waits for the earlier stores of the core to reach memory,
+ * so the write-back buffer has to drain
+ */
+void Cache::fence() {
+
+   num_fences_++;
+   num_fence_write_backs_ += wb_count_;
+   while (wb_count_ > 0) {
+      drain_write_back();
+   }
 }
 
 /******************************************************************/
 
-CacheBlock* Cache::find_block(ulong addr) {
+void Cache::set_prefetcher(Prefetcher *prefetcher) {
+   prefetcher_ = prefetcher;
+   prefetch_candidates_.reserve(16);
+}
+
+/**
+ * @brief Let the prefetcher observe a demand access, and fetch the blocks it suggests.
+ * A prefetch is a read miss like any other: it goes through the same state transition
+ * and bus transaction, so it can invalidate or intervene in the other caches.
+ * 
+ * @param addr The demand access
+ * @param trigger Whether the demand access missed, or hit a prefetched block
+ */
+void Cache::prefetch(ulong addr, bool trigger) {
+
+   prefetch_candidates_.clear();
+   prefetcher_->observe(addr, trigger, prefetch_candidates_);
+
+   for (ulong candidate : prefetch_candidates_) {
+
+      /* A block in the victim cache is still in this cache, a second copy would escape coherence */
+      if (find_block(candidate) != NULL || (num_victim_entries_ > 0 && find_victim(calc_tag(candidate)) >= 0)) {
+         continue;
+      }
+
+      CacheBlock *block = fill_block(candidate);
+      update_LRU(block);
+
+      bus_transaction_t prefetch_trans (id_, candidate);
+      prefetch_trans.cycle = current_cycle_;
+      prefetch_trans.time  = local_time();
+      Port<bus_transaction_t>::request(prefetch_trans);
+      prefetch_trans.bus_signals = block->next_state(op_e::PrRdMiss, prefetch_trans.copies_exist);
+      Port<bus_transaction_t>::send(prefetch_trans);
+
+      block->set_prefetched(true);
+
+      num_prefetches_++;
+      num_prefetch_bus_transactions_ += prefetch_trans.bus_signals.size();
+      num_prefetch_invalidations_    += prefetch_trans.num_invalidations;
+      num_prefetch_interventions_    += prefetch_trans.num_interventions;
+      num_prefetch_flushes_          += prefetch_trans.num_flushes;
+   }
+}
+
+/******************************************************************/
+
+/* Return the way that holds the block, or -1 on a miss */
+long Cache::find_way(ulong addr) {
+
+   if (__builtin_expect(index_ == index_e::Skewed, 0)) {
+      return find_skewed_way(addr);
+   }
+
+   const set_t &set = sets_[calc_index(addr)];
+
+   /* Nothing was ever filled into a set that has not been materialized */
+   if (set.tags == NULL) {
+      return -1;
+   }
+   return tag_match_(set.tags, assoc_, calc_tag(addr));
+}
+
+/* With a skewed index, the block can only be in way j of its set for way j */
+long Cache::find_skewed_way(ulong addr) {
 
    ulong tag = calc_tag(addr);
-   ulong i   = calc_index(addr);
-  
-   for(ulong j = 0; j < assoc_; j++){
-      if(cache_[i][j]->is_valid() && cache_[i][j]->get_tag() == tag) {
-         return cache_[i][j];
+   for (ulong j = 0; j < assoc_; j++) {
+      const set_t &set = sets_[calc_index(addr, j)];
+      if (set.tags != NULL && set.tags[j] == tag) {
+         return j;
       }
    }
-   return NULL;
+   return -1;
+}
+
+CacheBlock* Cache::find_block(ulong addr) {
+
+   long j = find_way(addr);
+   if (j < 0) {
+      return NULL;
+   }
+   return sets_[calc_index(addr, j)].blocks[j];
 }
 
 /******************************************************************/
@@ -135,58 +528,98 @@ void Cache::update_LRU(CacheBlock *block) {
 
 /******************************************************************/
 
-/* Return an invalid block as LRU, if any, otherwise return LRU block */
-CacheBlock * Cache::get_LRU(ulong addr) {
+/* Return an invalid way as LRU, if any, otherwise return LRU way */
+ulong Cache::get_LRU(ulong addr) {
 
    ulong victim = assoc_;
    ulong min    = current_cycle_;
-   ulong i      = calc_index(addr);
+
+   /* With a skewed index, the candidates are way j of the set of every way j */
+   if (index_ == index_e::Skewed) {
+      for (ulong j = 0; j < assoc_; j++) {
+         set_t &set = touch_set(calc_index(addr, j));
+         if (set.tags[j] == INVALID_TAG) {
+            return j;
+         }
+         if (set.blocks[j]->get_seq() <= min) {
+            victim = j;
+            min = set.blocks[j]->get_seq();
+         }
+      }
+      assert(victim != assoc_);
+      return victim;
+   }
+
+   set_t &set   = touch_set(calc_index(addr));
    
-   for(ulong j = 0; j < assoc_; j++) {
-      if(cache_[i][j]->is_valid() == 0) { 
-         return cache_[i][j]; 
-      }   
+   long invalid = tag_match_(set.tags, assoc_, INVALID_TAG);
+   if (invalid >= 0) {
+      return invalid;
    }
 
    for(ulong j = 0; j < assoc_; j++) {
-      if(cache_[i][j]->get_seq() <= min) { 
+      if(set.blocks[j]->get_seq() <= min) { 
          victim = j; 
-         min = cache_[i][j]->get_seq();}
+         min = set.blocks[j]->get_seq();}
    } 
 
    assert(victim != assoc_);
    
-   return cache_[i][victim];
+   return victim;
 }
 
 /******************************************************************/
 
-/* Evict a victim block from the cache */
-CacheBlock *Cache::find_block_to_replace(ulong addr) {
+/* Evict a victim block from the cache and return its way */
+ulong Cache::find_block_to_replace(ulong addr) {
 
-   CacheBlock *victim = get_LRU(addr);
+   ulong way = get_LRU(addr);
+   set_t &set = sets_[calc_index(addr, way)];
+   CacheBlock *victim = set.blocks[way];
 
-   if (victim->is_dirty()) {
-      num_write_backs_++;
+   /* With a victim cache, the victim moves there and the LRU entry of the victim cache leaves instead */
+   if (num_victim_entries_ > 0 && victim->is_valid()) {
+      victim = stash_victim(set, way);
    }
 
-   if (victim->is_valid()) {
+   /* Remember what leaves the cache, for the outcome stream */
+   evicted_       = victim->is_valid();
+   evicted_dirty_ = victim->is_dirty();
+   evicted_addr_  = calc_addr_for_tag(victim->get_tag());
+
+   if (evicted_dirty_) {
+      write_back(evicted_addr_);
+   }
+
+   if (evicted_) {
+      if (victim->is_prefetched()) {
+         num_useless_prefetches_++;
+      }
       victim->invalidate();
    }
+   victim->set_prefetched(false);
 
-   return (victim);
+   return (way);
 }
 
 /******************************************************************/
 
 /* Allocate a new block */
 CacheBlock *Cache::fill_block(ulong addr) { 
+
+   /* Memory must have the data of a block still waiting in the write-back buffer before the fill reads it */
+   if (wb_count_ > 0) {
+      retire_write_back(addr);
+   }
   
-   CacheBlock *victim = find_block_to_replace(addr);
-   assert(victim != 0);
+   ulong way = find_block_to_replace(addr);
+   set_t &set = sets_[calc_index(addr, way)];
+   CacheBlock *victim = set.blocks[way];
       
+   /* The requesting core always ends up with a valid copy, so the tag can be published right away */
    ulong tag = calc_tag(addr);   
    victim->set_tag(tag);
+   set.tags[way] = tag;
    return victim;
 }
 
@@ -197,17 +630,51 @@ CacheBlock *Cache::fill_block(ulong addr) {
  * 
  * @param trans BusRd/BusRdx/BusUpd
  */
-void Cache::receive(const bus_transaction_t &trans) {
+void Cache::receive(bus_transaction_t &trans) {
 
-   CacheBlock *block = find_block(trans.addr);
+   CacheBlock *block = NULL;
+   ulong *tag        = NULL;
+
+   long way = find_way(trans.addr);
+   if (way >= 0) {
+      set_t &set = sets_[calc_index(trans.addr, way)];
+      block = set.blocks[way];
+      tag   = &set.tags[way];
+   } 
+   else if (num_victim_entries_ > 0) {
+      long entry = find_victim(calc_tag(trans.addr));
+      if (entry >= 0) {
+         block = victim_blocks_[entry];
+         tag   = &victim_tags_[entry];
+      }
+   }
+
+   ulong num_flushes = trans.num_flushes;
 
    /** 
-    * The block in the receiving core is already INVALID
-    * and there is no change to its state.
+    * If the block is INVALID in the receiving core
+    * there is no change to its state.
     */
-   if (block == NULL) {
-      return;
+   if (block != NULL) {
+      snoop_block(block, tag, trans);
+   }
+
+   if (wb_buffer_size_ > 0) {
+      snoop_write_back(trans, trans.num_flushes != num_flushes);
    }
+}
+
+/**
+ * @brief Apply the snooped bus signals to a valid block
+ * 
+ * @param block 
+ * @param tag The packed tag of the block, cleared if the block gets invalidated
+ * @param trans 
+ */
+void Cache::snoop_block(CacheBlock *block, ulong *tag, bus_transaction_t &trans) {
+
+   ulong num_interventions = coherence_stats_.num_interventions;
+   ulong num_invalidations = coherence_stats_.num_invalidations;
 
    for (bus_signal_e requesting_core_signal : trans.bus_signals) {
 
@@ -216,6 +683,23 @@ void Cache::receive(const bus_transaction_t &trans) {
       /* A flush results in a writeback */
       if (std::find (receiving_core_signals.begin(), receiving_core_signals.end(), bus_signal_e::Flush) != receiving_core_signals.end()) {
          num_write_backs_++;
+         trans.num_flushes++;
+      }
+   }
+
+   if (coherence_stats_.num_interventions != num_interventions) {
+      trans.num_interventions++;
+   }
+   if (coherence_stats_.num_invalidations != num_invalidations) {
+      trans.num_invalidations++;
+   }
+
+   /* Keep the packed tags in sync with snoop invalidations */
+   if (!block->is_valid()) {
+      *tag = INVALID_TAG;
+      if (block->is_prefetched()) {
+         num_useless_prefetches_++;
+         block->set_prefetched(false);
       }
    }
 }
@@ -230,7 +714,12 @@ void Cache::respond(bus_transaction_t &trans) {
 
    CacheBlock *block = find_block(trans.addr);
 
-   if (block == NULL) {
+   if (block == NULL && num_victim_entries_ > 0 && find_victim(calc_tag(trans.addr)) >= 0) {
+      trans.copies_exist |= true;
+   } else if (block == NULL && wb_count_ > 0 && find_write_back(trans.addr) >= 0) {
+      /* The write-back buffer holds a dirty copy until it reaches memory */
+      trans.copies_exist |= true;
+   } else if (block == NULL) {
       trans.copies_exist |= false;
    } else {
       trans.copies_exist |= true;
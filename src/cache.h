@@ -4,19 +4,128 @@
 #include "types.h"
 #include "port.h"
 #include "cache_block.h"  
+#include "tag_match.h"
+#include "arena.h"
+#include "prefetcher.h"
+#include "outcome.h"
+#include "profile.h"
+
+/**
+ * @brief A snapshot of the counters of a single cache
+ */
+struct cache_stats_t {
+   /* Performance counters. Writebacks count once they reach memory, so the counters of a live cache never go down */
+   ulong num_reads{0}, num_read_misses{0}, num_writes{0}, num_write_misses{0}, num_write_backs{0};
+
+   /* Coherence counters */
+   coherence_stats_t coherence;
+
+   /* Prefetch counters. The lead is the number of accesses between a prefetch and the first demand for the block */
+   ulong num_prefetches{0}, num_useful_prefetches{0}, num_useless_prefetches{0}, prefetch_lead{0};
+
+   /* Coherence activity caused in other caches by prefetches */
+   ulong num_prefetch_bus_transactions{0}, num_prefetch_invalidations{0}, num_prefetch_interventions{0}, num_prefetch_flushes{0};
+
+   /**
+    * Misses served by the victim cache, writebacks the write-back buffer absorbed, flushes it answered snoops with,
+    * and entries written back early because the cache missed on their block again
+    */
+   ulong num_victim_hits{0}, num_wb_coalesced{0}, num_wb_snoop_flushes{0}, num_wb_retired{0};
+
+   /**
+    * Entries of the write-back buffer at the time of the snapshot. A snoop may still drop them,
+    * so they are not writebacks yet.
+    */
+   ulong num_wb_pending{0};
+
+   /* Atomics are counted apart from the reads and writes, with the coherence activity they caused in other caches */
+   ulong num_atomics{0}, num_atomic_misses{0};
+   ulong num_atomic_bus_transactions{0}, num_atomic_invalidations{0}, num_atomic_flushes{0};
+
+   /* Fences, and the writebacks they forced out of the write-back buffer */
+   ulong num_fences{0}, num_fence_write_backs{0};
+
+   double miss_rate() const {
+      ulong num_accesses = num_reads + num_writes;
+      return num_accesses ? (double) (num_read_misses + num_write_misses) * 100 / num_accesses : 0.0;
+   }
+
+   /* Prefetches and atomic misses fetch blocks from memory too */
+   ulong num_memory_transactions() const {
+      return num_read_misses + num_write_misses + num_write_backs + num_prefetches + num_atomic_misses;
+   }
+
+   double atomic_miss_rate() const {
+      return num_atomics ? (double) num_atomic_misses * 100 / num_atomics : 0.0;
+   }
+
+   double prefetch_accuracy() const {
+      return num_prefetches ? (double) num_useful_prefetches * 100 / num_prefetches : 0.0;
+   }
+
+   /* Share of the misses that would have happened without a prefetcher that were avoided */
+   double prefetch_coverage() const {
+      ulong num_misses = num_useful_prefetches + num_read_misses + num_write_misses;
+      return num_misses ? (double) num_useful_prefetches * 100 / num_misses : 0.0;
+   }
+
+   double average_prefetch_lead() const {
+      return num_useful_prefetches ? (double) prefetch_lead / num_useful_prefetches : 0.0;
+   }
+};
 
 /**
  * The Cache extends Port<bus_transaction_t> in order to send and receive bus transactions
 */
 class Cache : public Port<bus_transaction_t>{
 private:
-   /* Data structure to model a cache */
-   using set_t = std::vector<CacheBlock*>;
-   using cache_t = std::vector<set_t>;
-   cache_t cache_; 
+   /**
+    * Data structure to model a cache. 
+    * A set is a packed array of tags, with INVALID_TAG for invalid ways, and the blocks they belong to.
+    * Lookups scan the tags with a SIMD kernel instead of chasing block pointers.
+    * The sets, their arrays and the blocks are all carved out of the simulation's arena.
+    * The arrays of a set stay NULL until the set is materialized.
+    */
+   struct set_t {
+      ulong      *tags{nullptr};
+      CacheBlock **blocks{nullptr};
+   };
+   set_t *sets_{nullptr};
+   Arena &arena_;
+   storage_e storage_;
+
+   /**
+    * Index function of the sets. With a skewed index, every way has its own index:
+    * way j of a block lives in way j of set calc_index(addr, j), and a lookup probes one set per way.
+    */
+   index_e index_;
+   bool plain_index_{true};    /* Modulo over a power of two sets, the common case is a mask */
+   bool pow2_sets_{true};
+   ulong num_prime_sets_{0};
+   ulong num_sets_touched_{0};
+
+   /* Tag matching kernels for the sets (possibly specialized for the associativity) and for the victim cache */
+   tag_match_fn_t tag_match_{nullptr};
+   tag_match_fn_t victim_match_{nullptr};
+
+   /* Access() dispatches to a version of access<>() specialized for the protocol of the cache, and for whether it is profiled */
+   using access_fn_t = void (Cache::*)(ulong addr, op_e op);
+   access_fn_t access_fn_{nullptr};
+   void select_access_fn();
 
    uint id_;
-   ulong current_cycle_;  
+   ulong current_cycle_{0};
+
+   /**
+    * Local time in the cycles of the timing model, for the bus bandwidth intervals.
+    * A Core sets the time before every access. Without one, the timed DRAM counts
+    * cycles_per_ref_ memory cycles per access. It is the arrival time of the DRAM requests.
+    */
+   ulong time_{0}, cycles_per_ref_{0};
+   ulong local_time() const { return time_ + current_cycle_ * cycles_per_ref_; }
+
+   /* Who served the last demand access */
+   service_e last_service_{service_e::Hit};
 
    /* Cache configuration */
    ulong size_, assoc_, block_size_, num_sets_{0}, num_index_bits_{0}, num_block_offset_bits_{0}, tag_mask_{0}, num_blocks_{0};
@@ -26,35 +135,106 @@ private:
    /* Performance counters */
    ulong num_reads_{0}, num_read_misses_{0}, num_writes_{0}, num_write_misses_{0}, num_write_backs_{0};
 
-   /* Coherence counters */
-   ulong num_invalidations_{0}, num_interventions_{0}, num_busrdx_{0}, num_busupd_{0}, num_flushes_{0};
+   /* Coherence counters, updated by the blocks of this cache */
+   coherence_stats_t coherence_stats_;
+
+   /* Optional prefetcher, and the addresses it suggested for the current access */
+   Prefetcher *prefetcher_{nullptr};
+   std::vector<ulong> prefetch_candidates_;
+
+   /**
+    * Optional fully associative victim cache, with its own packed tags.
+    * Blocks move between the sets and the victim cache by swapping pointers, so they keep their state.
+    */
+   ulong num_victim_entries_{0};
+   ulong *victim_tags_{nullptr};
+   CacheBlock **victim_blocks_{nullptr};
+
+   /* Optional write-back buffer: a ring of the addresses of dirty evictions on their way to memory */
+   ulong wb_buffer_size_{0}, wb_head_{0}, wb_count_{0};
+   ulong *wb_buffer_{nullptr};
 
-   ulong get_num_invalidations() const;
-   ulong get_num_interventions() const;
-   ulong get_num_busrdx() const;
-   ulong get_num_busupd() const;
-   ulong get_num_flushes() const;
+   /* Optional stream of the outcome of every access, and the block that the last fill evicted */
+   OutcomeWriter *outcomes_{nullptr};
+   ulong evicted_addr_{0};
+   bool  evicted_{false}, evicted_dirty_{false};
+
+   /* Optional profiler of the phases of the accesses */
+   Profiler *profiler_{nullptr};
+
+   /* Victim cache and write-back buffer counters */
+   ulong num_victim_hits_{0}, num_wb_coalesced_{0}, num_wb_snoop_flushes_{0}, num_wb_retired_{0};
+
+   /* Atomic and fence counters */
+   ulong num_atomics_{0}, num_atomic_misses_{0};
+   ulong num_atomic_bus_transactions_{0}, num_atomic_invalidations_{0}, num_atomic_flushes_{0};
+   ulong num_fences_{0}, num_fence_write_backs_{0};
+
+   /* Prefetch counters */
+   ulong num_prefetches_{0}, num_useful_prefetches_{0}, num_useless_prefetches_{0}, prefetch_lead_{0};
+   ulong num_prefetch_bus_transactions_{0}, num_prefetch_invalidations_{0}, num_prefetch_interventions_{0}, num_prefetch_flushes_{0};
+
+   set_t &touch_set(ulong index);
 
    ulong calc_tag(ulong addr);
-   ulong calc_index(ulong addr);
+   ulong calc_index(ulong addr, ulong way = 0) {
+      return plain_index_ ? ((addr >> num_block_offset_bits_) & tag_mask_) : calc_hashed_index(addr, way);
+   }
+   ulong calc_hashed_index(ulong addr, ulong way);
+   ulong reduce_index(ulong hash);
    ulong calc_addr_for_tag(ulong tag);
 
-   CacheBlock *find_block_to_replace(ulong addr);
+   ulong find_block_to_replace(ulong addr);
    CacheBlock *fill_block(ulong addr);
+   long find_way(ulong addr);
+   long find_skewed_way(ulong addr);
    CacheBlock *find_block(ulong addr);
-   CacheBlock *get_LRU(ulong);
+   ulong get_LRU(ulong);
    void update_LRU(CacheBlock *);
 
-   void receive(const bus_transaction_t &trans) override;
+   template <typename BLOCK, bool PROFILE>
+   void access(ulong addr, op_e op);
+   void prefetch(ulong addr, bool trigger);
+   void fence();
+   void record_outcome(ulong addr, op_e op, uint8_t flags, state_e state_before, CacheBlock *block, const bus_transaction_t &trans);
+
+   long find_victim(ulong tag);
+   CacheBlock *recover_victim(ulong addr);
+   CacheBlock *stash_victim(set_t &set, ulong way);
+   void write_back(ulong addr);
+   void send_write_back(ulong addr);
+   void drain_write_back();
+   long find_write_back(ulong addr);
+   void remove_write_back(ulong i);
+   void retire_write_back(ulong addr);
+   void snoop_write_back(bus_transaction_t &trans, bool flushed);
+   void snoop_block(CacheBlock *block, ulong *tag, bus_transaction_t &trans);
+
+   void receive(bus_transaction_t &trans) override;
    void respond(bus_transaction_t &trans) override;
    
 public:
      
-    Cache(uint id, ulong size, ulong assoc, ulong block_size, protocol_e protocol);
-   ~Cache();
+    Cache(uint id, ulong size, ulong assoc, ulong block_size, protocol_e protocol, Arena &arena, storage_e storage = storage_e::Dense,
+          index_e index = index_e::Modulo);
    
-   void Access(ulong addr, op_e op);
-   void print_stats();
+   void Access(ulong addr, op_e op) { (this->*access_fn_)(addr, op); }
+   bool access_local(ulong addr, op_e op);
+   void set_prefetcher(Prefetcher *prefetcher);
+   void set_victim_cache(ulong num_entries);
+   void set_write_back_buffer(ulong num_entries);
+   void set_outcome_stream(OutcomeWriter *outcomes) { outcomes_ = outcomes; }
+   void set_profiler(Profiler *profiler);
+   cache_stats_t get_stats() const;
+   void clear_stats();
+   ulong get_num_sets_touched() const { return num_sets_touched_; }
+   service_e get_last_service() const { return last_service_; }
+   ulong get_time() const { return local_time(); }
+   void set_time(ulong time) { time_ = time; }
+   void set_cycles_per_ref(ulong cycles_per_ref) { cycles_per_ref_ = cycles_per_ref; }
+   void print_stats() const;
 };
 
+void print_cache_stats(uint id, const std::string &protocol, const cache_stats_t &stats, bool prefetcher, bool victim_cache, bool wb_buffer, bool atomics);
+
 #endif
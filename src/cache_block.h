@@ -3,6 +3,14 @@
 
 #include "types.h"
 
+/**
+ * @brief Coherence counters shared by all the blocks of a cache.
+ * Blocks update them as a side effect of their state transitions.
+ */
+struct coherence_stats_t {
+   ulong num_invalidations{0}, num_interventions{0}, num_busrdx{0}, num_busupd{0}, num_flushes{0};
+};
+
 /**
  * @brief Abstract class. Derived classes define state transitions
  * based on the protocol that they implement.
@@ -12,12 +20,13 @@ class CacheBlock {
 private:
    ulong tag_{0};
    ulong seq_{0}; 
+   bool  prefetched_{false};  /* Brought in by a prefetch and not demanded yet */
 
 protected:
    state_e state_{state_e::INVALID};
 
-   /* Coherence counters */
-   ulong num_invalidations_{0}, num_interventions_{0}, num_busrdx_{0}, num_busupd_{0}, num_flushes_{0};
+   /* Coherence counters of the cache that owns the block */
+   coherence_stats_t *stats_{nullptr};
 
 public:
    CacheBlock()                  {}
@@ -27,24 +36,28 @@ public:
    ulong get_seq() const         { return seq_; }
    void set_seq(ulong seq)       { seq_ = seq; }
    void set_tag(ulong tag)       { tag_ = tag; }
+   bool is_prefetched() const    { return prefetched_; }
+   void set_prefetched(bool p)   { prefetched_ = p; }
    void invalidate()             { state_ = state_e::INVALID; }
    bool is_valid()               { return (state_ != state_e::INVALID);}
    virtual bool is_dirty() const = 0;
    
-   ulong get_num_invalidations() const { return num_invalidations_; }
-   ulong get_num_interventions() const { return num_interventions_; }
-   ulong get_num_busrdx()        const { return num_busrdx_; }
-   ulong get_num_busupd()        const { return num_busupd_; }
-   ulong get_num_flushes()       const { return num_flushes_; }
+   void set_stats(coherence_stats_t *stats) { stats_ = stats; }
 
    /**
     * For the requesting core, the next state depends on:
-    * 1. The operation (PrRd/PrWr/PrRdMiss/PrWrMiss)
+    * 1. The operation (PrRd/PrWr/PrAtomic and their misses)
     * 2. Whether other caches have the block (copies_exist)
     * 3. The current state
    */
    virtual bus_signal_t next_state(op_e op, bool copies_exist) = 0;
 
+   /**
+    * Whether the operation completes on a valid block without a bus signal,
+    * whatever the other caches hold. Such a hit involves no other cache.
+    */
+   virtual bool is_silent(op_e op) const = 0;
+
    /**
     * For the receiving core, the next state depends on:
     * 1. The bus signal (BusRd/BusRdX/BusUpd/etc)
@@ -1,11 +1,14 @@
+#ifndef __CACHE_BLOCK_DRAGON_H__
+#define __CACHE_BLOCK_DRAGON_H__
+
 #include <assert.h>
+#include <iostream>
 #include "cache_block.h"
-#include "factory.h"
 
 /**
  * @brief Implement a state machine for the Dragon protocol
  */
-class CacheBlockDragon : public CacheBlock {
+class CacheBlockDragon final : public CacheBlock {
 
 public:
     CacheBlockDragon()
@@ -18,10 +21,17 @@ public:
         return (state_ == state_e::MODIFIED || state_ == state_e::SHARED_MODIFIED);
     }
 
+    /* Reads never need the bus, writes and atomics only when nobody else can have a copy */
+    bool is_silent(op_e op) const override {
+        return (op == op_e::PrRd) || (state_ == state_e::MODIFIED) || (state_ == state_e::EXCLUSIVE);
+    }
+
     /**
      * @brief Next state transition for a cache block on the REQUESTING core.
      * 
-     * @param op: The operation (R/W) issued by the requesting core.
+     * @param op: The operation (R/W/atomic) issued by the requesting core.
+     * Atomics cannot be completed by an update: they take exclusive ownership with a BusRdX
+     * that invalidates the other copies.
      * @param copies_exist: Whether other caches have a copy of the block.
      * @return bus_signal_e: A bus signal that results from the state transition.
      */
@@ -47,7 +57,12 @@ public:
                 else if (op == op_e::PrWrMiss && copies_exist) {
                     next_state = state_e::SHARED_MODIFIED;
                     bus_signals = {bus_signal_e::BusRd, bus_signal_e::BusUpd};
-                    num_busupd_++;
+                    stats_->num_busupd++;
+                }
+                else if (op == op_e::PrAtomicMiss) {
+                    next_state = state_e::MODIFIED;
+                    bus_signals = {bus_signal_e::BusRdX};
+                    stats_->num_busrdx++;
                 }
                 else {
                     FATAL("Encountered invalid operation " << op);
@@ -59,7 +74,7 @@ public:
                 if (op == op_e::PrRd) {
                     next_state = state_e::MODIFIED;
                 }
-                else if (op == op_e::PrWr) {
+                else if (op == op_e::PrWr || op == op_e::PrAtomic) {
                     next_state = state_e::MODIFIED;
                 }
                 else {
@@ -72,7 +87,7 @@ public:
                 if (op == op_e::PrRd) {
                     next_state = state_e::EXCLUSIVE;
                 }
-                else if (op == op_e::PrWr) {
+                else if (op == op_e::PrWr || op == op_e::PrAtomic) {
                     next_state = state_e::MODIFIED;
                 } 
                 else {
@@ -87,12 +102,20 @@ public:
                 else if (op == op_e::PrWr && !copies_exist) {
                     next_state = state_e::MODIFIED;
                     bus_signals = {bus_signal_e::BusUpd};
-                    num_busupd_++;
+                    stats_->num_busupd++;
                 }
                 else if (op == op_e::PrWr && copies_exist) {
                     next_state = state_e::SHARED_MODIFIED;
                     bus_signals = {bus_signal_e::BusUpd};
-                    num_busupd_++;
+                    stats_->num_busupd++;
+                }
+                else if (op == op_e::PrAtomic && !copies_exist) {
+                    next_state = state_e::MODIFIED;
+                }
+                else if (op == op_e::PrAtomic && copies_exist) {
+                    next_state = state_e::MODIFIED;
+                    bus_signals = {bus_signal_e::BusRdX};
+                    stats_->num_busrdx++;
                 }
                 else {
                     FATAL("Encountered invalid operation " << op);
@@ -106,12 +129,20 @@ public:
                 else if (op == op_e::PrWr && !copies_exist) {
                     next_state = state_e::MODIFIED;
                     bus_signals = {bus_signal_e::BusUpd};
-                    num_busupd_++;
+                    stats_->num_busupd++;
                 }
                 else if (op == op_e::PrWr && copies_exist) {
                     next_state = state_e::SHARED_MODIFIED;
                     bus_signals = {bus_signal_e::BusUpd};
-                    num_busupd_++;
+                    stats_->num_busupd++;
+                }
+                else if (op == op_e::PrAtomic && !copies_exist) {
+                    next_state = state_e::MODIFIED;
+                }
+                else if (op == op_e::PrAtomic && copies_exist) {
+                    next_state = state_e::MODIFIED;
+                    bus_signals = {bus_signal_e::BusRdX};
+                    stats_->num_busrdx++;
                 }
                 else {
                     FATAL("Encountered invalid operation " << op);
@@ -141,8 +172,14 @@ public:
                 switch(signal) {
                     case bus_signal_e::BusRd    : next_state = state_e::SHARED_MODIFIED;
                                                   bus_signals = {bus_signal_e::Flush};
-                                                  num_interventions_++;
-                                                  num_flushes_++;
+                                                  stats_->num_interventions++;
+                                                  stats_->num_flushes++;
+                                                  break;
+
+                    case bus_signal_e::BusRdX   : next_state = state_e::INVALID;
+                                                  bus_signals = {bus_signal_e::Flush};
+                                                  stats_->num_invalidations++;
+                                                  stats_->num_flushes++;
                                                   break;
 
                     default                     : FATAL("Encountered invalid signal " << signal);
@@ -153,7 +190,11 @@ public:
             case state_e::EXCLUSIVE:
                 switch(signal) {
                     case bus_signal_e::BusRd    : next_state = state_e::SHARED_CLEAN;
-                                                  num_interventions_++;
+                                                  stats_->num_interventions++;
+                                                  break;
+
+                    case bus_signal_e::BusRdX   : next_state = state_e::INVALID;
+                                                  stats_->num_invalidations++;
                                                   break;
 
                     default                     : FATAL("Encountered invalid signal " << signal);
@@ -166,6 +207,10 @@ public:
                     case bus_signal_e::BusRd    : next_state = state_e::SHARED_CLEAN; 
                                                   break;
 
+                    case bus_signal_e::BusRdX   : next_state = state_e::INVALID;
+                                                  stats_->num_invalidations++;
+                                                  break;
+
                     case bus_signal_e::BusUpd   : next_state = state_e::SHARED_CLEAN; 
                                                   bus_signals = {bus_signal_e::Update}; 
                                                   break;
@@ -185,7 +230,13 @@ public:
                 switch(signal) {
                     case bus_signal_e::BusRd    : next_state = state_e::SHARED_MODIFIED; 
                                                   bus_signals = {bus_signal_e::Flush};
-                                                  num_flushes_++;
+                                                  stats_->num_flushes++;
+                                                  break;
+
+                    case bus_signal_e::BusRdX   : next_state = state_e::INVALID;
+                                                  bus_signals = {bus_signal_e::Flush};
+                                                  stats_->num_invalidations++;
+                                                  stats_->num_flushes++;
                                                   break;
 
                     case bus_signal_e::BusUpd   : next_state = state_e::SHARED_CLEAN;
@@ -211,4 +262,4 @@ public:
     }
 };
 
-FACTORY_REGISTER("Dragon", CacheBlockDragon);
+#endif /* __CACHE_BLOCK_DRAGON_H__ */
@@ -1,11 +1,14 @@
+#ifndef __CACHE_BLOCK_MSI_H__
+#define __CACHE_BLOCK_MSI_H__
+
+#include <iostream>
 #include "cache_block.h"
-#include "factory.h"
 
 /**
  * @brief Implement a state machine for a modified version
  * of the MSI protocol
  */
-class CacheBlockMSI : public CacheBlock {
+class CacheBlockMSI final : public CacheBlock {
 
 public:
     CacheBlockMSI()
@@ -18,11 +21,16 @@ public:
         return (state_ == state_e::MODIFIED);
     }
 
+    /* Only an atomic on a CLEAN block has to find out about the other copies */
+    bool is_silent(op_e op) const override {
+        return (state_ == state_e::MODIFIED) || (state_ == state_e::CLEAN && op != op_e::PrAtomic);
+    }
+
     /**
      * @brief Next state transition for a cache block on the REQUESTING core.
      * 
-     * @param op: The operation (R/W) issued by the requesting core.
-     * @param copies_exist: Not used for the MSI protocol.
+     * @param op: The operation (R/W/atomic) issued by the requesting core.
+     * @param copies_exist: Whether other caches have a copy of the block. Only atomics use it.
      * @return bus_signal_e: A bus signal that results from the state transition.
      */
     bus_signal_t next_state(op_e op, bool copies_exist) override {
@@ -35,10 +43,10 @@ public:
                     next_state = state_e::CLEAN;
                     bus_signals = {bus_signal_e::BusRd};
                 } 
-                else if (op == op_e::PrWrMiss) {
+                else if (op == op_e::PrWrMiss || op == op_e::PrAtomicMiss) {
                     next_state = state_e::MODIFIED;
                     bus_signals = {bus_signal_e::BusRdX};
-                    num_busrdx_++;
+                    stats_->num_busrdx++;
                 }
                 else {
                     FATAL("Encountered invalid operation " << op);
@@ -52,6 +60,15 @@ public:
                 else if (op == op_e::PrWr) {
                     next_state = state_e::MODIFIED;
                 }
+                /* Unlike a write, an atomic has to own the block: the other copies are invalidated */
+                else if (op == op_e::PrAtomic && copies_exist) {
+                    next_state = state_e::MODIFIED;
+                    bus_signals = {bus_signal_e::BusRdX};
+                    stats_->num_busrdx++;
+                }
+                else if (op == op_e::PrAtomic && !copies_exist) {
+                    next_state = state_e::MODIFIED;
+                }
                 else {
                     FATAL("Encountered invalid operation " << op);
                 }
@@ -61,7 +78,7 @@ public:
                 if (op == op_e::PrRd) {
                     next_state = state_e::MODIFIED;
                 }
-                else if (op == op_e::PrWr) {
+                else if (op == op_e::PrWr || op == op_e::PrAtomic) {
                     next_state = state_e::MODIFIED;
                 }
                 else {
@@ -91,14 +108,14 @@ public:
 
             case state_e::CLEAN:
                 next_state = state_e::INVALID;
-                num_invalidations_++;
+                stats_->num_invalidations++;
                 break;
 
             case state_e::MODIFIED:
                 next_state = state_e::INVALID;
                 bus_signals = {bus_signal_e::Flush};
-                num_invalidations_++;
-                num_flushes_++;
+                stats_->num_invalidations++;
+                stats_->num_flushes++;
                 break;
 
             default:
@@ -109,15 +126,4 @@ public:
     }
 };
 
-FACTORY_REGISTER("MSI", CacheBlockMSI);
-
-
-
-
-
-
-
-
-
-
-
+#endif /* __CACHE_BLOCK_MSI_H__ */
@@ -19,41 +19,161 @@
       printf("%02d. %-43s %.2lf%%\n", i, s, d); \
    } while(0)
 
+#define TRACE_STATSD(i, s, d) \
+   do { \
+      printf("%02d. %-43s %.2lf\n", i, s, d); \
+   } while(0)
+
+
+/**
+ * @brief Take a snapshot of the counters. Cheap enough to be called at any time.
+ */
+cache_stats_t Cache::get_stats() const {
+
+   cache_stats_t stats;
+
+   stats.num_reads         = num_reads_;
+   stats.num_read_misses   = num_read_misses_;
+   stats.num_writes        = num_writes_;
+   stats.num_write_misses  = num_write_misses_;
+   stats.num_write_backs   = num_write_backs_;
+   stats.coherence         = coherence_stats_;
+
+   stats.num_prefetches                = num_prefetches_;
+   stats.num_useful_prefetches         = num_useful_prefetches_;
+   stats.num_useless_prefetches        = num_useless_prefetches_;
+   stats.prefetch_lead                 = prefetch_lead_;
+   stats.num_prefetch_bus_transactions = num_prefetch_bus_transactions_;
+   stats.num_prefetch_invalidations    = num_prefetch_invalidations_;
+   stats.num_prefetch_interventions    = num_prefetch_interventions_;
+   stats.num_prefetch_flushes          = num_prefetch_flushes_;
+
+   stats.num_victim_hits               = num_victim_hits_;
+   stats.num_wb_coalesced              = num_wb_coalesced_;
+   stats.num_wb_snoop_flushes          = num_wb_snoop_flushes_;
+   stats.num_wb_retired                = num_wb_retired_;
+   stats.num_wb_pending                = wb_count_;
+
+   stats.num_atomics                   = num_atomics_;
+   stats.num_atomic_misses             = num_atomic_misses_;
+   stats.num_atomic_bus_transactions   = num_atomic_bus_transactions_;
+   stats.num_atomic_invalidations      = num_atomic_invalidations_;
+   stats.num_atomic_flushes            = num_atomic_flushes_;
+   stats.num_fences                    = num_fences_;
+   stats.num_fence_write_backs         = num_fence_write_backs_;
+
+   return stats;
+}
+
+/**
+ * @brief Restart every counter without touching the contents of the cache,
+ * e.g. at the end of a warm-up
+ */
+void Cache::clear_stats() {
+
+   num_reads_        = 0;
+   num_read_misses_  = 0;
+   num_writes_       = 0;
+   num_write_misses_ = 0;
+   num_write_backs_  = 0;
+   coherence_stats_  = coherence_stats_t();
+
+   num_prefetches_                = 0;
+   num_useful_prefetches_         = 0;
+   num_useless_prefetches_        = 0;
+   prefetch_lead_                 = 0;
+   num_prefetch_bus_transactions_ = 0;
+   num_prefetch_invalidations_    = 0;
+   num_prefetch_interventions_    = 0;
+   num_prefetch_flushes_          = 0;
+
+   num_victim_hits_       = 0;
+   num_wb_coalesced_      = 0;
+   num_wb_snoop_flushes_  = 0;
+   num_wb_retired_        = 0;
+
+   num_atomics_                 = 0;
+   num_atomic_misses_           = 0;
+   num_atomic_bus_transactions_ = 0;
+   num_atomic_invalidations_    = 0;
+   num_atomic_flushes_          = 0;
+   num_fences_                  = 0;
+   num_fence_write_backs_       = 0;
+}
 
-void Cache::print_stats() { 
-
-   /* Gather coherence counters */
-   for(uint i = 0; i < num_sets_; i++) {
-      for(uint j = 0; j < assoc_; j++) {
-         num_invalidations_   += cache_[i][j]->get_num_invalidations();
-         num_interventions_   += cache_[i][j]->get_num_interventions();
-         num_busrdx_          += cache_[i][j]->get_num_busrdx();
-         num_busupd_          += cache_[i][j]->get_num_busupd();    
-         num_flushes_         += cache_[i][j]->get_num_flushes();
-      }
-   } 
-
-   double miss_rate = (double) (num_read_misses_ + num_write_misses_) * 100 / (num_reads_ + num_writes_);
-   ulong num_memory_transactions = num_read_misses_ + num_write_misses_ + num_write_backs_;
-
-   BANNER("Simulation results (Cache %u)", id_);
-
-   TRACE_STATS (1, "number of reads:",                   num_reads_);
-   TRACE_STATS (2, "number of read misses:",             num_read_misses_);
-   TRACE_STATS (3, "number of writes:",                  num_writes_);
-   TRACE_STATS (4, "number of write misses:",            num_write_misses_);
-   TRACE_STATSF(5, "total miss rate:",                   miss_rate);
-   TRACE_STATS (6, "number of writebacks:",              num_write_backs_);
-   TRACE_STATS (7, "number of memory transactions:",     num_memory_transactions);
-   if (protocol_ == "MSI") {
-   TRACE_STATS (8, "number of invalidations:",           num_invalidations_);
-   TRACE_STATS (9, "number of flushes:",                 num_flushes_);
-   TRACE_STATS (10, "number of BusRdX:",                 num_busrdx_);
-   }
-   else if (protocol_ == "Dragon") {
-   TRACE_STATS (8, "number of interventions:",           num_interventions_);
-   TRACE_STATS (9, "number of flushes:",                 num_flushes_);
-   TRACE_STATS (10, "number of Bus Transactions(BusUpd):", num_busupd_);
+void Cache::print_stats() const { 
+   cache_stats_t stats = get_stats();
+   print_cache_stats(id_, protocol_, stats, prefetcher_ != NULL, num_victim_entries_ > 0, wb_buffer_size_ > 0,
+                     stats.num_atomics > 0 || stats.num_fences > 0);
+}
+
+/**
+ * @brief Print a snapshot of the counters of a cache. The optional sections
+ * are printed for the features that the cache has enabled, and for atomics
+ * and fences when the trace has any.
+ */
+void print_cache_stats(uint id, const std::string &protocol, const cache_stats_t &stats, bool prefetcher, bool victim_cache, bool wb_buffer, bool atomics) {
+
+   BANNER("Simulation results (Cache %u)", id);
+
+   TRACE_STATS (1, "number of reads:",                   stats.num_reads);
+   TRACE_STATS (2, "number of read misses:",             stats.num_read_misses);
+   TRACE_STATS (3, "number of writes:",                  stats.num_writes);
+   TRACE_STATS (4, "number of write misses:",            stats.num_write_misses);
+   TRACE_STATSF(5, "total miss rate:",                   stats.miss_rate());
+   TRACE_STATS (6, "number of writebacks:",              stats.num_write_backs);
+   TRACE_STATS (7, "number of memory transactions:",     stats.num_memory_transactions());
+   if (protocol == "MSI") {
+   TRACE_STATS (8, "number of invalidations:",           stats.coherence.num_invalidations);
+   TRACE_STATS (9, "number of flushes:",                 stats.coherence.num_flushes);
+   TRACE_STATS (10, "number of BusRdX:",                 stats.coherence.num_busrdx);
+   }
+   else if (protocol == "Dragon") {
+   TRACE_STATS (8, "number of interventions:",           stats.coherence.num_interventions);
+   TRACE_STATS (9, "number of flushes:",                 stats.coherence.num_flushes);
+   TRACE_STATS (10, "number of Bus Transactions(BusUpd):", stats.coherence.num_busupd);
+
+   }
+
+   /* Optional sections are numbered after the protocol counters */
+   int line = 11;
+
+   if (prefetcher) {
+   TRACE_STATS (line++, "number of prefetches:",             stats.num_prefetches);
+   TRACE_STATS (line++, "number of useful prefetches:",      stats.num_useful_prefetches);
+   TRACE_STATS (line++, "number of useless prefetches:",     stats.num_useless_prefetches);
+   TRACE_STATSF(line++, "prefetch accuracy:",                stats.prefetch_accuracy());
+   TRACE_STATSF(line++, "prefetch coverage:",                stats.prefetch_coverage());
+   TRACE_STATSD(line++, "prefetch lead (accesses):",         stats.average_prefetch_lead());
+   TRACE_STATS (line++, "prefetch bus transactions:",        stats.num_prefetch_bus_transactions);
+   if (protocol == "MSI") {
+   TRACE_STATS (line++, "prefetch-induced invalidations:",   stats.num_prefetch_invalidations);
+   }
+   else if (protocol == "Dragon") {
+   TRACE_STATS (line++, "prefetch-induced interventions:",   stats.num_prefetch_interventions);
+   }
+   TRACE_STATS (line++, "prefetch-induced flushes:",         stats.num_prefetch_flushes);
+   }
+
+   if (victim_cache) {
+   TRACE_STATS (line++, "conflict misses recovered (victim):", stats.num_victim_hits);
+   }
+
+   if (wb_buffer) {
+   TRACE_STATS (line++, "writebacks absorbed (WB buffer):",  stats.num_wb_coalesced);
+   TRACE_STATS (line++, "flushes from the WB buffer:",       stats.num_wb_snoop_flushes);
+   TRACE_STATS (line++, "re-misses on the WB buffer:",       stats.num_wb_retired);
+   TRACE_STATS (line++, "writebacks still in the WB buffer:", stats.num_wb_pending);
+   }
 
+   if (atomics) {
+   TRACE_STATS (line++, "number of atomics:",                stats.num_atomics);
+   TRACE_STATS (line++, "number of atomic misses:",          stats.num_atomic_misses);
+   TRACE_STATSF(line++, "atomic miss rate:",                 stats.atomic_miss_rate());
+   TRACE_STATS (line++, "atomic bus transactions:",          stats.num_atomic_bus_transactions);
+   TRACE_STATS (line++, "atomic-induced invalidations:",     stats.num_atomic_invalidations);
+   TRACE_STATS (line++, "atomic-induced flushes:",           stats.num_atomic_flushes);
+   TRACE_STATS (line++, "number of fences:",                 stats.num_fences);
+   TRACE_STATS (line++, "writebacks drained by fences:",     stats.num_fence_write_backs);
    }
 }
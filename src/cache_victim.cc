@@ -0,0 +1,232 @@
+#include <assert.h>
+#include "cache.h"
+#include "factory.h"
+
+/**
+ * @brief Give the cache a fully associative victim cache.
+ * Its blocks are created up front, since it is tiny.
+ * 
+ * @param num_entries 0 disables the victim cache
+ */
+void Cache::set_victim_cache(ulong num_entries) {
+
+   num_victim_entries_ = num_entries;
+   if (num_entries == 0) {
+      return;
+   }
+
+   victim_tags_   = arena_.allocate_array<ulong>(num_entries);
+   victim_blocks_ = arena_.allocate_array<CacheBlock *>(num_entries);
+
+   for (ulong j = 0; j < num_entries; j++) {
+      victim_tags_[j]   = INVALID_TAG;
+      victim_blocks_[j] = FACTORY_CREATE(protocol_, arena_);
+      victim_blocks_[j]->set_stats(&coherence_stats_);
+      victim_blocks_[j]->invalidate();
+   }
+}
+
+/**
+ * @brief Give the cache a buffer that holds dirty evictions until they have to be written to memory
+ * 
+ * @param num_entries 0 disables the write-back buffer
+ */
+void Cache::set_write_back_buffer(ulong num_entries) {
+
+   wb_buffer_size_ = num_entries;
+   if (num_entries > 0) {
+      wb_buffer_ = arena_.allocate_array<ulong>(num_entries);
+   }
+}
+
+/******************************************************************/
+
+/* Return the victim cache entry that holds the block, or -1 */
+long Cache::find_victim(ulong tag) {
+   return victim_match_(victim_tags_, num_victim_entries_, tag);
+}
+
+/**
+ * @brief A miss in the sets hit in the victim cache: swap the block back into its set.
+ * The block it replaces in the set takes its place in the victim cache,
+ * so nothing leaves the cache and no bus transaction is needed.
+ * 
+ * @param addr 
+ * @return CacheBlock* The recovered block, or NULL if the victim cache does not have it either
+ */
+CacheBlock *Cache::recover_victim(ulong addr) {
+
+   ulong tag   = calc_tag(addr);
+   long  entry = find_victim(tag);
+   if (entry < 0) {
+      return NULL;
+   }
+
+   ulong way  = get_LRU(addr);
+   set_t &set = sets_[calc_index(addr, way)];
+
+   CacheBlock *block     = victim_blocks_[entry];
+   victim_blocks_[entry] = set.blocks[way];
+   victim_tags_[entry]   = set.tags[way];
+   victim_blocks_[entry]->set_seq(current_cycle_);
+
+   set.blocks[way] = block;
+   set.tags[way]   = tag;
+
+   num_victim_hits_++;
+   return block;
+}
+
+/**
+ * @brief Move the victim of a set into the victim cache.
+ * 
+ * @param set 
+ * @param way The way of the victim in the set
+ * @return CacheBlock* The LRU entry of the victim cache, which now sits in the set and has to be evicted
+ */
+CacheBlock *Cache::stash_victim(set_t &set, ulong way) {
+
+   long entry = find_victim(INVALID_TAG);
+   if (entry < 0) {
+      entry = 0;
+      for (ulong j = 1; j < num_victim_entries_; j++) {
+         if (victim_blocks_[j]->get_seq() < victim_blocks_[entry]->get_seq()) {
+            entry = j;
+         }
+      }
+   }
+
+   CacheBlock *displaced = victim_blocks_[entry];
+   victim_blocks_[entry] = set.blocks[way];
+   victim_tags_[entry]   = set.tags[way];
+   victim_blocks_[entry]->set_seq(current_cycle_);
+
+   set.blocks[way] = displaced;
+   set.tags[way]   = INVALID_TAG;
+   return displaced;
+}
+
+/******************************************************************/
+
+/**
+ * @brief Write a dirty block back to memory.
+ * With a write-back buffer, the writeback waits in the buffer, and a second
+ * eviction of the same block while it waits is merged into the same entry.
+ * 
+ * @param addr 
+ */
+void Cache::write_back(ulong addr) {
+
+   if (wb_buffer_size_ == 0) {
+      send_write_back(addr);
+      return;
+   }
+
+   if (find_write_back(addr) >= 0) {
+      num_wb_coalesced_++;
+      return;
+   }
+
+   if (wb_count_ == wb_buffer_size_) {
+      drain_write_back();
+   }
+   wb_buffer_[(wb_head_ + wb_count_) % wb_buffer_size_] = addr;
+   wb_count_++;
+}
+
+/* Post the writeback of a block to memory */
+void Cache::send_write_back(ulong addr) {
+
+   num_write_backs_++;
+   bus_transaction_t writeback (id_, addr, {bus_signal_e::WriteBack});
+   writeback.cycle = current_cycle_;
+   writeback.time  = local_time();
+   Port<bus_transaction_t>::send(writeback);
+}
+
+/**
+ * @brief Write the oldest entry of the write-back buffer to memory
+ */
+void Cache::drain_write_back() {
+
+   assert(wb_count_ > 0);
+   ulong addr = wb_buffer_[wb_head_];
+   wb_head_   = (wb_head_ + 1) % wb_buffer_size_;
+   wb_count_--;
+
+   send_write_back(addr);
+}
+
+/* Return the position of the block in the write-back buffer, from the oldest entry, or -1 */
+long Cache::find_write_back(ulong addr) {
+
+   addr = calc_addr_for_tag(calc_tag(addr));
+   for (ulong i = 0; i < wb_count_; i++) {
+      if (wb_buffer_[(wb_head_ + i) % wb_buffer_size_] == addr) {
+         return i;
+      }
+   }
+   return -1;
+}
+
+/* Take an entry out of the write-back buffer, keeping the others in age order */
+void Cache::remove_write_back(ulong i) {
+
+   for (ulong j = i; j + 1 < wb_count_; j++) {
+      wb_buffer_[(wb_head_ + j) % wb_buffer_size_] = wb_buffer_[(wb_head_ + j + 1) % wb_buffer_size_];
+   }
+   wb_count_--;
+}
+
+/**
+ * @brief The cache misses on a block that still waits in its write-back buffer.
+ * The entry holds the only up-to-date copy of the block, so it is written to memory
+ * ahead of the fill, which then reads the data it just wrote.
+ * 
+ * @param addr 
+ */
+void Cache::retire_write_back(ulong addr) {
+
+   long i = find_write_back(addr);
+   if (i < 0) {
+      return;
+   }
+
+   ulong block_addr = wb_buffer_[(wb_head_ + i) % wb_buffer_size_];
+   remove_write_back(i);
+   num_wb_retired_++;
+   send_write_back(block_addr);
+}
+
+/**
+ * @brief The write-back buffer holds the only up-to-date copy of its blocks, so it snoops too.
+ * A read of a buffered block is answered with a flush, which also updates memory and retires the entry.
+ * If a block of this cache already flushed the same data, or a BusUpd made another cache the owner
+ * of the block, the buffered writeback is no longer needed and is dropped.
+ * 
+ * @param trans 
+ * @param flushed Whether one of the blocks of this cache already flushed the block
+ */
+void Cache::snoop_write_back(bus_transaction_t &trans, bool flushed) {
+
+   long i = find_write_back(trans.addr);
+   if (i < 0) {
+      return;
+   }
+
+   bool read = false;
+   for (bus_signal_e signal : trans.bus_signals) {
+      read |= (signal == bus_signal_e::BusRd || signal == bus_signal_e::BusRdX);
+   }
+
+   if (read && !flushed) {
+      trans.num_flushes++;
+      coherence_stats_.num_flushes++;
+      num_write_backs_++;
+      num_wb_snoop_flushes_++;
+   } 
+   else {
+      num_wb_coalesced_++;
+   }
+   remove_write_back(i);
+}
@@ -0,0 +1,147 @@
+#include <stdio.h>
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+#include "core.h"
+
+Core::Core(const core_config_t &config, Cache *cache)
+: config_ {config}
+, cache_ {cache}
+{
+    if (!(config_.ipc > 0.0)) {
+        FATAL(": The IPC of a core must be positive");
+    }
+    if (config_.num_mshrs == 0) {
+        FATAL(": A core needs at least one MSHR");
+    }
+    mshrs_.resize(config_.num_mshrs, 0.0);
+}
+
+void Core::Access(ulong addr, op_e op, ulong gap) {
+    issue(gap + 1);
+    cache_->set_time((ulong) time_);
+    cache_->Access(addr, op);
+    retire(op, (op == op_e::PrFence) ? service_e::Hit : cache_->get_last_service());
+}
+
+bool Core::access_local(ulong addr, op_e op, ulong gap) {
+    if (!cache_->access_local(addr, op)) {
+        return false;
+    }
+    issue(gap + 1);
+    retire(op, service_e::Hit);
+    return true;
+}
+
+ulong Core::latency(service_e service) {
+    switch (service) {
+        case service_e::Upgrade:
+            num_upgrades_++;
+            return config_.upgrade_latency;
+        case service_e::Remote:
+            num_remote_fills_++;
+            return config_.remote_latency;
+        case service_e::Memory:
+            num_memory_fills_++;
+            return config_.memory_latency;
+        default:
+            return 0;
+    }
+}
+
+/**
+ * @brief Account for the latency of a reference that was just issued
+ *
+ * @param op
+ * @param service who served the reference
+ */
+void Core::retire(op_e op, service_e service) {
+
+    if (op == op_e::PrFence || op == op_e::PrAtomic) {
+        drain();
+    }
+
+    ulong cycles = latency(service);
+    if (cycles == 0) {
+        return;
+    }
+    miss_cycles_ += cycles;
+
+    /* An atomic blocks the core until it completes */
+    if (op == op_e::PrAtomic) {
+        time_ += cycles;
+        return;
+    }
+
+    /* A miss takes the MSHR that frees up first */
+    std::vector<double>::iterator mshr = std::min_element(mshrs_.begin(), mshrs_.end());
+    if (*mshr > time_) {
+        num_mshr_stalls_++;
+        mshr_stall_cycles_ += *mshr - time_;
+        time_ = *mshr;
+    }
+    *mshr = time_ + cycles;
+}
+
+/* Wait for every outstanding miss */
+void Core::drain() {
+    num_drains_++;
+    double last = *std::max_element(mshrs_.begin(), mshrs_.end());
+    if (last > time_) {
+        drain_stall_cycles_ += last - time_;
+        time_ = last;
+    }
+}
+
+core_stats_t Core::get_stats() const {
+
+    core_stats_t stats;
+    double end = std::max(time_, *std::max_element(mshrs_.begin(), mshrs_.end()));
+
+    stats.num_instructions      = num_instructions_;
+    stats.num_cycles            = (ulong) std::ceil(end - start_);
+    stats.num_upgrades          = num_upgrades_;
+    stats.num_remote_fills      = num_remote_fills_;
+    stats.num_memory_fills      = num_memory_fills_;
+    stats.num_mshr_stalls       = num_mshr_stalls_;
+    stats.mshr_stall_cycles     = (ulong) std::ceil(mshr_stall_cycles_);
+    stats.num_drains            = num_drains_;
+    stats.drain_stall_cycles    = (ulong) std::ceil(drain_stall_cycles_);
+    stats.miss_cycles           = miss_cycles_;
+    return stats;
+}
+
+void Core::clear_stats() {
+    start_ = time_;
+
+    num_instructions_   = 0;
+    num_upgrades_       = 0;
+    num_remote_fills_   = 0;
+    num_memory_fills_   = 0;
+    num_mshr_stalls_    = 0;
+    num_drains_         = 0;
+    miss_cycles_        = 0;
+    mshr_stall_cycles_  = 0.0;
+    drain_stall_cycles_ = 0.0;
+}
+
+/**
+ * @brief Print the timing of every core. The run takes as long as its slowest core.
+ */
+void print_core_stats(const core_config_t &config, const std::vector<core_stats_t> &cores) {
+
+    printf("============ Core timing (IPC %.2lf, %lu MSHRs, latencies %lu/%lu/%lu) ============\n",
+           config.ipc, config.num_mshrs, config.upgrade_latency, config.remote_latency, config.memory_latency);
+    printf("%-10s %14s %14s %8s %12s %12s %12s %14s %14s %10s\n", "core", "instructions", "cycles", "IPC",
+           "upgrades", "remote", "memory", "MSHR stalls", "drain stalls", "in flight");
+
+    ulong num_cycles = 0;
+    for (ulong core = 0; core < cores.size(); core++) {
+        const core_stats_t &c = cores[core];
+        printf("core %-5lu %14lu %14lu %8.2lf %12lu %12lu %12lu %14lu %14lu %10.2lf\n", core, c.num_instructions,
+               c.num_cycles, c.ipc(), c.num_upgrades, c.num_remote_fills, c.num_memory_fills,
+               c.mshr_stall_cycles, c.drain_stall_cycles, c.memory_parallelism());
+        num_cycles = std::max(num_cycles, c.num_cycles);
+    }
+    printf("%-30s %14lu\n", "execution time (cycles):", num_cycles);
+}
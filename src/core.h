@@ -0,0 +1,95 @@
+#ifndef __CORE_H__
+#define __CORE_H__
+
+#include <vector>
+#include "types.h"
+#include "cache.h"
+
+/**
+ * @brief Issue rate and memory-level parallelism of a core. Latencies are in core cycles.
+ */
+struct core_config_t {
+    double ipc{1.0};                /* Instructions issued per cycle when nothing stalls */
+    ulong  num_mshrs{8};            /* Misses a core can have outstanding */
+    ulong  upgrade_latency{10};     /* A hit that needs a bus transaction for its permission */
+    ulong  remote_latency{40};      /* A miss that another cache supplies */
+    ulong  memory_latency{100};     /* A miss that memory supplies */
+};
+
+/**
+ * @brief A snapshot of the counters of a core
+ */
+struct core_stats_t {
+    ulong num_instructions{0};      /* Memory references included */
+    ulong num_cycles{0};            /* Until the last outstanding miss completes */
+    ulong num_upgrades{0}, num_remote_fills{0}, num_memory_fills{0};
+    ulong num_mshr_stalls{0}, mshr_stall_cycles{0};     /* Misses that found every MSHR busy */
+    ulong num_drains{0}, drain_stall_cycles{0};         /* Fences and atomics waiting for the outstanding misses */
+    ulong miss_cycles{0};           /* Sum of the latencies of the misses and upgrades */
+
+    double ipc() const {
+        return num_cycles ? (double) num_instructions / num_cycles : 0.0;
+    }
+
+    /* Misses in flight, on average over the run */
+    double memory_parallelism() const {
+        return num_cycles ? (double) miss_cycles / num_cycles : 0.0;
+    }
+};
+
+void print_core_stats(const core_config_t &config, const std::vector<core_stats_t> &cores);
+
+/**
+ * @brief Timing front end of a core, in front of its cache.
+ *
+ * The core issues the instructions between two references of the trace at a
+ * fixed IPC, and does not wait for its misses: every miss holds an MSHR for its
+ * latency, and the core only stalls when it needs an MSHR and none is free.
+ * Hits are fully pipelined. Fences and atomics wait for every outstanding miss,
+ * and an atomic also waits for its own.
+ *
+ * The latency of an access only depends on who served it (see service_e), the
+ * cache itself stays untimed and processes every access as it is issued.
+ */
+class Core {
+private:
+    core_config_t config_;
+    Cache *cache_;
+
+    /* Time of the next issue, and completion of the miss held by every MSHR */
+    double time_{0.0};
+    std::vector<double> mshrs_;
+
+    /* Time of the last clear_stats, the cycles of the core count from there */
+    double start_{0.0};
+
+    ulong num_instructions_{0};
+    ulong num_upgrades_{0}, num_remote_fills_{0}, num_memory_fills_{0};
+    ulong num_mshr_stalls_{0}, num_drains_{0}, miss_cycles_{0};
+    double mshr_stall_cycles_{0.0}, drain_stall_cycles_{0.0};
+
+    void issue(ulong num_instructions) {
+        num_instructions_ += num_instructions;
+        time_ += num_instructions / config_.ipc;
+    }
+
+    ulong latency(service_e service);
+    void retire(op_e op, service_e service);
+    void drain();
+
+public:
+    Core(const core_config_t &config, Cache *cache);
+
+    /* A reference after `gap` other instructions of the core */
+    void Access(ulong addr, op_e op, ulong gap);
+
+    /* Same as Cache::access_local, performs the reference only if it stays in the cache */
+    bool access_local(ulong addr, op_e op, ulong gap);
+
+    core_stats_t get_stats() const;
+
+    /* The cycles count from now on. The time keeps running, it is also the time of the DRAM requests */
+    void clear_stats();
+};
+
+#endif /* __CORE_H__ */
@@ -0,0 +1,167 @@
+#include <iostream>
+#include <algorithm>
+#include "dram.h"
+
+Dram::Dram(const dram_config_t &config)
+: config_ {config}
+{
+    if (config_.num_channels == 0 || config_.num_banks == 0) {
+        FATAL(": The DRAM needs at least one channel and one bank");
+    }
+    blocks_per_row_ = std::max(config_.row_bytes / config_.block_bytes, 1UL);
+
+    channels_.resize(config_.num_channels);
+    for (channel_t &channel : channels_) {
+        channel.banks.resize(config_.num_banks);
+        channel.queue.reserve(config_.queue_depth);
+    }
+}
+
+/**
+ * @brief Bring `row` into the row buffer of `bank` and classify the access
+ *
+ * @return the latency of the access up to its data transfer
+ */
+ulong Dram::open_row(bank_t &bank, ulong row) {
+
+    ulong latency;
+    if (bank.open_row == (long) row) {
+        stats_.num_row_hits++;
+        latency = config_.t_cas;
+    } else if (bank.open_row < 0) {
+        stats_.num_row_misses++;
+        latency = config_.t_rcd + config_.t_cas;
+    } else {
+        stats_.num_row_conflicts++;
+        latency = config_.t_rp + config_.t_rcd + config_.t_cas;
+    }
+
+    /* A closed page policy precharges right after the access, so that the next one only has to activate */
+    bank.open_row = (config_.policy == dram_policy_e::Open) ? (long) row : -1;
+    return latency;
+}
+
+/**
+ * @brief Serve one queued request of a channel, picked FR-FCFS among the requests
+ * that have arrived by `start`: the oldest row hit, or else the oldest request.
+ *
+ * @param channel
+ * @param start the earliest cycle the channel can start an access
+ */
+void Dram::serve(channel_t &channel, ulong start) {
+
+    std::vector<request_t> &queue = channel.queue;
+    size_t oldest = queue.size(), oldest_hit = queue.size();
+
+    for (size_t i = 0; i < queue.size(); i++) {
+        const request_t &r = queue[i];
+        if (r.arrival > start) {
+            continue;
+        }
+        if (oldest == queue.size() || r.arrival < queue[oldest].arrival) {
+            oldest = i;
+        }
+        bool hit = (channel.banks[r.bank].open_row == (long) r.row);
+        if (hit && (oldest_hit == queue.size() || r.arrival < queue[oldest_hit].arrival)) {
+            oldest_hit = i;
+        }
+    }
+
+    size_t pick = (oldest_hit != queue.size()) ? oldest_hit : oldest;
+    assert(pick != queue.size());
+    request_t r = queue[pick];
+    queue.erase(queue.begin() + pick);
+
+    bank_t &bank = channel.banks[r.bank];
+    ulong begin  = std::max(start, bank.ready);
+    ulong done   = begin + open_row(bank, r.row) + config_.t_burst;
+
+    /* Transfers share the data bus of the channel */
+    done = std::max(done, channel.data_free + config_.t_burst);
+    channel.data_free  = done;
+    channel.next_issue = start + config_.t_burst;
+    bank.ready = done + ((config_.policy == dram_policy_e::Closed) ? config_.t_rp : 0);
+
+    if (!r.write) {
+        stats_.read_latency += done - r.arrival;
+    }
+    stats_.num_cycles = std::max(stats_.num_cycles, (done > start_) ? done - start_ : 0);
+}
+
+/* The channel can start its next access once it is free and a request has arrived */
+ulong Dram::earliest_start(const channel_t &channel) const {
+    ulong arrival = ~0UL;
+    for (const request_t &r : channel.queue) {
+        arrival = std::min(arrival, r.arrival);
+    }
+    return std::max(channel.next_issue, arrival);
+}
+
+/**
+ * @brief Serve the queued requests of a channel that can start before `until`
+ */
+void Dram::schedule(channel_t &channel, ulong until) {
+    while (!channel.queue.empty() && earliest_start(channel) <= until) {
+        serve(channel, earliest_start(channel));
+    }
+}
+
+void Dram::access(ulong addr, ulong time, bool write) {
+
+    ulong block   = addr / config_.block_bytes;
+    ulong rest    = block / blocks_per_row_;
+    channel_t &channel = channels_[rest % config_.num_channels];
+    rest /= config_.num_channels;
+
+    request_t request;
+    request.bank    = rest % config_.num_banks;
+    request.row     = rest / config_.num_banks;
+    request.write   = write;
+    request.arrival = time;
+
+    (write ? stats_.num_writes : stats_.num_reads)++;
+    stats_.num_bytes += config_.block_bytes;
+
+    if (config_.mode == dram_mode_e::Untimed) {
+        ulong latency = open_row(channel.banks[request.bank], request.row) + config_.t_burst;
+        if (!write) {
+            stats_.read_latency += latency;
+        }
+        return;
+    }
+
+    /* Serve what the channel could have served by now, and make room for the request */
+    schedule(channel, request.arrival);
+    if (channel.queue.size() >= config_.queue_depth) {
+        serve(channel, earliest_start(channel));
+    }
+    channel.queue.push_back(request);
+    stats_.max_queue = std::max(stats_.max_queue, (ulong) channel.queue.size());
+}
+
+dram_stats_t Dram::get_stats() const {
+    Dram copy(*this);
+    for (channel_t &channel : copy.channels_) {
+        copy.schedule(channel, ~0UL);
+    }
+    return copy.stats_;
+}
+
+void print_dram_stats(const dram_config_t &config, const dram_stats_t &stats) {
+
+    std::cout << "============ DRAM (" << config.num_channels << " channels, " << config.num_banks << " banks, "
+              << config.policy << " page, " << config.mode << ") ============\n";
+    printf("%-30s %14lu\n",     "reads:",                    stats.num_reads);
+    printf("%-30s %14lu\n",     "writes:",                   stats.num_writes);
+    printf("%-30s %14lu\n",     "row hits:",                 stats.num_row_hits);
+    printf("%-30s %14lu\n",     "row misses:",               stats.num_row_misses);
+    printf("%-30s %14lu\n",     "row conflicts:",            stats.num_row_conflicts);
+    printf("%-30s %13.2lf%%\n", "row buffer hit rate:",      stats.row_hit_rate());
+    printf("%-30s %14.2lf\n",   "average read latency:",     stats.average_latency());
+    printf("%-30s %14lu\n",     "bytes transferred:",        stats.num_bytes);
+    if (config.mode == dram_mode_e::Timed) {
+        printf("%-30s %14lu\n",     "cycles:",                   stats.num_cycles);
+        printf("%-30s %14.2lf\n",   "bandwidth (bytes/cycle):",  stats.bandwidth());
+        printf("%-30s %14lu\n",     "peak queue occupancy:",     stats.max_queue);
+    }
+}
@@ -0,0 +1,121 @@
+#ifndef __DRAM_H__
+#define __DRAM_H__
+
+#include <vector>
+#include "types.h"
+
+/**
+ * @brief Organization and timing of the DRAM. Timings are in memory cycles.
+ */
+struct dram_config_t {
+    ulong         num_channels{1};
+    ulong         num_banks{8};         /* Per channel */
+    dram_policy_e policy{dram_policy_e::Open};
+    dram_mode_e   mode{dram_mode_e::Untimed};
+
+    ulong         block_bytes{64};
+    ulong         row_bytes{8192};
+    ulong         queue_depth{32};      /* Requests a channel can hold before it has to serve one */
+
+    /**
+     * In timed mode without core timing, a core issues one reference every cycles_per_ref cycles.
+     * With core timing, requests arrive at the cycle of their core and memory runs at the core clock.
+     */
+    ulong         cycles_per_ref{4};
+
+    ulong         t_cas{14};            /* Column access of an open row */
+    ulong         t_rcd{14};            /* Activation of a row */
+    ulong         t_rp{14};             /* Precharge of the open row */
+    ulong         t_burst{4};           /* Transfer of a block on the data bus */
+};
+
+/**
+ * @brief A snapshot of the counters of the DRAM
+ */
+struct dram_stats_t {
+    ulong num_reads{0}, num_writes{0};
+    ulong num_row_hits{0}, num_row_misses{0}, num_row_conflicts{0};
+    ulong read_latency{0};      /* Sum over the reads, queueing included in timed mode */
+    ulong num_bytes{0};
+    ulong num_cycles{0};        /* Completion of the last access since the counters were cleared, timed mode only */
+    ulong max_queue{0};
+
+    ulong num_accesses() const { return num_reads + num_writes; }
+
+    double row_hit_rate() const {
+        return num_accesses() ? (double) num_row_hits * 100 / num_accesses() : 0.0;
+    }
+
+    double average_latency() const {
+        return num_reads ? (double) read_latency / num_reads : 0.0;
+    }
+
+    /* Bytes per memory cycle */
+    double bandwidth() const {
+        return num_cycles ? (double) num_bytes / num_cycles : 0.0;
+    }
+};
+
+void print_dram_stats(const dram_config_t &config, const dram_stats_t &stats);
+
+/**
+ * @brief Main memory behind the interconnect: channels of banks with a row buffer each.
+ * Consecutive blocks share a row, then rows are interleaved across channels, then banks.
+ *
+ * Untimed, every access is served as it arrives and only the state of the row
+ * buffer decides its latency. Timed, accesses wait in a queue per channel and the
+ * channel serves row hits first, then the oldest access (FR-FCFS). Banks work in
+ * parallel and the channel starts a new access every t_burst cycles at most.
+ */
+class Dram {
+private:
+    struct request_t {
+        ulong arrival;
+        ulong bank;
+        ulong row;
+        bool  write;
+    };
+
+    struct bank_t {
+        long  open_row{-1};
+        ulong ready{0};
+    };
+
+    struct channel_t {
+        std::vector<bank_t>    banks;
+        std::vector<request_t> queue;
+        ulong next_issue{0};
+        ulong data_free{0};
+    };
+
+    dram_config_t config_;
+    ulong blocks_per_row_{1};
+    std::vector<channel_t> channels_;
+    dram_stats_t stats_;
+
+    /* Time the counters were last cleared at, the cycles count from there */
+    ulong start_{0};
+
+    ulong open_row(bank_t &bank, ulong row);
+    ulong earliest_start(const channel_t &channel) const;
+    void serve(channel_t &channel, ulong start);
+    void schedule(channel_t &channel, ulong until);
+
+public:
+    explicit Dram(const dram_config_t &config);
+
+    /* An access to the block of `addr` by a core at its local `time` (see bus_transaction_t::time) */
+    void access(ulong addr, ulong time, bool write);
+
+    /* Accesses still queued are served in a copy, so that a snapshot does not disturb the schedule */
+    dram_stats_t get_stats() const;
+    /* Restart the counters at time `now`, the schedule keeps its absolute times */
+    void clear_stats(ulong now) {
+        stats_ = dram_stats_t();
+        start_ = now;
+    }
+
+    const dram_config_t &get_config() const { return config_; }
+};
+
+#endif /* __DRAM_H__ */
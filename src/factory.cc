@@ -4,29 +4,43 @@
  * @brief 
  * 
  * @param name The name of the derived class
- * @param callback The callback function used to create an object from the derived class
+ * @param entry The callback function used to create an object from the derived class, and the object's size
  */
-void Factory::register_class (const std::string &name, callback_t callback) {
-    class_registry[name] = callback;
+void Factory::register_class (const std::string &name, const class_entry_t &entry) {
+    class_registry[name] = entry;
 }
 
- /**
- * @brief Create a derived object from the base class `CacheBlock`
+/**
+ * @brief Find the registry entry of a derived class
  * 
- * @param name: A string that determines the derived object that will be created
- * @return std::shared_ptr<CacheBlock> 
+ * @param name 
+ * @return const class_entry_t& 
  */
-CacheBlock* Factory::create(const std::string &name) {
+const class_entry_t &Factory::lookup(const std::string &name) {
 
     class_registry_it entry = class_registry.find(name);
     if (entry != class_registry.end()) {
-        /* Call the callback function. This creates a derived object */
-        return (entry->second)();
+        return entry->second;
     }
     fprintf (stderr, "ERROR: Type %s not registered with the object factory.\n", name.c_str());
     exit (EXIT_FAILURE);
 }
 
+ /**
+ * @brief Create a derived object from the base class `CacheBlock`
+ * 
+ * @param name: A string that determines the derived object that will be created
+ * @param arena: The arena that the object is placed in. The object is never deleted,
+ * it goes away when the arena is reset.
+ * @return CacheBlock* 
+ */
+CacheBlock* Factory::create(const std::string &name, Arena &arena) {
+
+    const class_entry_t &entry = lookup(name);
+    /* Call the callback function. This creates a derived object */
+    return entry.callback(arena.allocate(entry.size, entry.align));
+}
+
 Factory* Factory::get_instance() {
     static Factory factory;
     return &factory;
@@ -39,6 +53,6 @@ Factory* Factory::get_instance() {
  * globally, but we can't.
  * So we do it in the constructor of this class.
  */
-Registry::Registry(const std::string &name, callback_t callback) {
-    Factory::get_instance()->register_class(name, callback);
+Registry::Registry(const std::string &name, const class_entry_t &entry) {
+    Factory::get_instance()->register_class(name, entry);
 }
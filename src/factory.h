@@ -4,6 +4,7 @@
 #include <string>
 #include <map>
 #include "cache_block.h"
+#include "arena.h"
 #include <iostream>
 
 /**
@@ -12,12 +13,22 @@
 
 /**
  * @brief callback_t is a pointer to a function that return CacheBlock* 
- * and takes in no arguments.
- * i.e., it is a pointer to a function that creates a new CacheBlock.
+ * and takes in the memory that the block should be constructed in.
+ * i.e., it is a pointer to a function that creates a new CacheBlock in place.
  */
-// using callback_t = std::function<CacheBlock*(void)>;
-using callback_t = CacheBlock* (*)();
-using class_registry_t =  std::map<std::string, callback_t>;
+// using callback_t = std::function<CacheBlock*(void*)>;
+using callback_t = CacheBlock* (*)(void *);
+
+/**
+ * @brief Everything the factory needs to know in order to place a derived object in an arena
+ */
+struct class_entry_t {
+    callback_t  callback;
+    size_t      size;
+    size_t      align;
+};
+
+using class_registry_t =  std::map<std::string, class_entry_t>;
 using class_registry_it = class_registry_t::iterator;
 
 class Factory {
@@ -25,23 +36,33 @@ private:
     class_registry_t class_registry;
 
 public:
-    void register_class (const std::string &name, callback_t callback);
-    CacheBlock* create(const std::string &name);
+    void register_class (const std::string &name, const class_entry_t &entry);
+    const class_entry_t &lookup(const std::string &name);
+    CacheBlock* create(const std::string &name, Arena &arena);
 
     static Factory* get_instance();
 };
 
 class Registry {
 public:
-    Registry (const std::string &name, callback_t callback);
+    Registry (const std::string &name, const class_entry_t &entry);
 };
 
-#define FACTORY_CREATE(NAME) \
-    Factory::get_instance()->create(NAME);
+#define FACTORY_CREATE(NAME, ARENA) \
+    Factory::get_instance()->create(NAME, ARENA);
+
+/* The registry entry of a derived class */
+#define FACTORY_ENTRY(TYPE) \
+    class_entry_t {\
+        [](void *mem)->CacheBlock* {return new (mem) TYPE();}, /* This is the callback function */ \
+        sizeof(TYPE), alignof(TYPE)}
 
+/**
+ * Registers a class from a static initializer. Only use it in a file the program links directly:
+ * the linker leaves out the objects of a static library that nothing references, and their initializers with them.
+ */
 #define FACTORY_REGISTER(NAME, TYPE) \
-    static Registry registry(NAME, \
-        [](void)->CacheBlock* {return new TYPE();}); /* This is the callback function */
+    static Registry registry(NAME, FACTORY_ENTRY(TYPE));
 
 
 #endif /* __FACTORY_H__ */
\ No newline at end of file
@@ -0,0 +1,317 @@
+#include <iostream>
+#include <cmath>
+#include "interconnect.h"
+
+Interconnect::Interconnect(const interconnect_config_t &config, const bus_config_t &bus_config, Arena &arena)
+: Port<bus_transaction_t> ()
+, config_ {config}
+, num_block_offset_bits_ {(ulong) log2(bus_config.block_bytes)}
+{
+    if (config_.num_banks == 0) {
+        FATAL(": The interconnect needs at least one bus bank");
+    }
+    if (config_.num_sockets == 0 || config_.num_sockets > config_.num_cores) {
+        FATAL(": Cannot split " << config_.num_cores << " cores into " << config_.num_sockets << " sockets");
+    }
+    if (config_.num_sockets > 8 * sizeof(ulong)) {
+        FATAL(": At most " << 8 * sizeof(ulong) << " sockets are supported");
+    }
+
+    /* Every socket is the home of some blocks, so none of them may be left without cores */
+    socket_of_ = config_.socket_map;
+    if (socket_of_.empty()) {
+        for (ulong core = 0; core < config_.num_cores; core++) {
+            socket_of_.push_back(core * config_.num_sockets / config_.num_cores);
+        }
+    }
+    if (socket_of_.size() != config_.num_cores) {
+        FATAL(": The socket map has " << socket_of_.size() << " entries for " << config_.num_cores << " cores");
+    }
+    std::vector<ulong> num_socket_cores(config_.num_sockets, 0);
+    for (ulong socket : socket_of_) {
+        if (socket >= config_.num_sockets) {
+            FATAL(": Socket " << socket << " does not exist");
+        }
+        num_socket_cores[socket]++;
+    }
+    for (ulong socket = 0; socket < config_.num_sockets; socket++) {
+        if (num_socket_cores[socket] == 0) {
+            FATAL(": Socket " << socket << " has no core");
+        }
+    }
+
+    buses_.resize(config_.num_sockets * config_.num_banks);
+    for (Bus *&bus : buses_) {
+        bus = arena.create<Bus>(config_.num_cores, bus_config);
+    }
+}
+
+/* The buses live in the arena, only their destructors need to run */
+Interconnect::~Interconnect() {
+    for (Bus *bus : buses_) {
+        bus->~Bus();
+    }
+}
+
+void Interconnect::attach(Port<bus_transaction_t> *cache, ulong core) {
+    ulong socket = get_socket(core);
+    for (ulong bank = 0; bank < config_.num_banks; bank++) {
+        buses_[socket * config_.num_banks + bank]->attach(cache, core);
+    }
+}
+
+void Interconnect::set_memory(Dram *memory) {
+    for (Bus *bus : buses_) {
+        bus->set_memory(memory);
+    }
+}
+
+void Interconnect::set_profiler(Profiler *profiler) {
+    for (Bus *bus : buses_) {
+        bus->set_profiler(profiler);
+    }
+}
+
+/**
+ * @brief Route a transaction to the bank that owns its block
+ * 
+ * @param trans 
+ */
+void Interconnect::receive(bus_transaction_t &trans) {
+
+    /* Hits that need no bus signal still post an empty transaction */
+    if (trans.bus_signals.empty()) {
+        return;
+    }
+
+    if (config_.num_sockets == 1) {
+        get_bus(0, trans.addr)->receive(trans);
+        return;
+    }
+    receive_numa(trans);
+}
+
+/**
+ * @brief Find out whether other caches have the block.
+ * With a directory, only the sockets that may hold the block are asked.
+ * 
+ * @param trans 
+ */
+void Interconnect::respond(bus_transaction_t &trans) {
+
+    if (config_.num_sockets == 1) {
+        get_bus(0, trans.addr)->respond(trans);
+        return;
+    }
+
+    ulong local = get_socket(trans.processor_id);
+    ulong sharers = ~0UL;
+    if (config_.numa == numa_e::Directory) {
+        auto entry = presence_.find(get_block(trans.addr));
+        sharers = (entry == presence_.end()) ? 0 : entry->second;
+    }
+
+    for (ulong socket = 0; socket < config_.num_sockets; socket++) {
+        if (socket == local || (sharers & (1UL << socket))) {
+            get_bus(socket, trans.addr)->respond(trans);
+        }
+    }
+}
+
+/**
+ * @brief Snoop the caches of one socket and attribute their responses
+ * 
+ * @param socket 
+ * @param trans 
+ * @param remote Whether the socket is not the requesting core's socket
+ */
+void Interconnect::snoop_socket(ulong socket, bus_transaction_t &trans, bool remote) {
+
+    ulong num_flushes       = trans.num_flushes;
+    ulong num_interventions = trans.num_interventions;
+
+    get_bus(socket, trans.addr)->snoop(trans);
+
+    ulong flushes       = trans.num_flushes - num_flushes;
+    ulong interventions = trans.num_interventions - num_interventions;
+
+    if (remote) {
+        numa_stats_.num_remote_flushes       += flushes;
+        numa_stats_.num_remote_interventions += interventions;
+    } else {
+        numa_stats_.num_local_flushes        += flushes;
+        numa_stats_.num_local_interventions  += interventions;
+    }
+}
+
+/**
+ * @brief Whether any cache of `socket` other than the requester still holds the block
+ */
+bool Interconnect::socket_has_copy(ulong socket, const bus_transaction_t &trans) {
+    bus_transaction_t query (trans.processor_id, trans.addr);
+    get_bus(socket, trans.addr)->respond(query);
+    return query.copies_exist;
+}
+
+/**
+ * @brief Memory lives at the home socket of the block. A remote access costs
+ * a request hop to the home socket and a reply hop back.
+ * 
+ * @param socket The socket that accesses memory
+ * @param addr 
+ * @param at_home Whether the request already reached the home socket (through the directory), which leaves the reply hop
+ */
+void Interconnect::access_memory(ulong socket, ulong addr, bool at_home) {
+    if (get_home(addr) == socket) {
+        numa_stats_.num_local_memory++;
+    } else {
+        numa_stats_.num_remote_memory++;
+        numa_stats_.num_hops += at_home ? 1 : 2;
+    }
+}
+
+/**
+ * @brief Carry a transaction across sockets.
+ * The local bus is always snooped. With broadcast, every remote socket is snooped
+ * and answers back (two hops each). With a directory, the request first goes to the
+ * home socket (one hop if it is remote), which forwards it to the sharer sockets only
+ * (one hop each), and they answer the requester directly (one hop each). If memory
+ * supplies the block, the home socket sends it back (one hop if it is remote).
+ * 
+ * @param trans 
+ */
+void Interconnect::receive_numa(bus_transaction_t &trans) {
+
+    ulong local = get_socket(trans.processor_id);
+    ulong home  = get_home(trans.addr);
+    Bus *bus    = get_bus(local, trans.addr);
+
+    /* Writebacks go straight to the home memory */
+    if (!bus->post(trans)) {
+        access_memory(local, trans.addr);
+        return;
+    }
+
+    numa_stats_.num_transactions++;
+    snoop_socket(local, trans, false);
+
+    ulong block   = get_block(trans.addr);
+    ulong sharers = ~0UL;
+    if (config_.numa == numa_e::Directory) {
+        sharers = presence_[block];
+        if (home != local) {
+            numa_stats_.num_hops++;
+        }
+    }
+
+    ulong presence = 1UL << local;
+    for (ulong socket = 0; socket < config_.num_sockets; socket++) {
+        if (socket == local) {
+            continue;
+        }
+        if (!(sharers & (1UL << socket))) {
+            numa_stats_.num_filtered_snoops++;
+            continue;
+        }
+
+        numa_stats_.num_remote_snoops++;
+        numa_stats_.num_hops += 2;
+        snoop_socket(socket, trans, true);
+
+        if (config_.numa == numa_e::Directory && socket_has_copy(socket, trans)) {
+            presence |= 1UL << socket;
+        }
+    }
+
+    /* The directory keeps the sockets that still hold the block after the snoops */
+    if (config_.numa == numa_e::Directory) {
+        presence_[block] = presence;
+    }
+
+    if (bus->reply(trans)) {
+        access_memory(local, trans.addr, config_.numa == numa_e::Directory);
+    }
+}
+
+/**
+ * @brief Total traffic over all the buses
+ * 
+ * @return bus_stats_t 
+ */
+bus_stats_t Interconnect::get_stats() const {
+    bus_stats_t stats;
+    for (const Bus *bus : buses_) {
+        stats += bus->get_stats();
+    }
+    return stats;
+}
+
+/**
+ * @brief Traffic of one bank, summed over all the sockets
+ * 
+ * @return bus_stats_t 
+ */
+bus_stats_t Interconnect::get_bank_stats(ulong bank) const {
+    bus_stats_t stats;
+    for (ulong socket = 0; socket < config_.num_sockets; socket++) {
+        stats += buses_[socket * config_.num_banks + bank]->get_stats();
+    }
+    return stats;
+}
+
+/**
+ * @brief Restart the traffic counters. The directory keeps its contents,
+ * like the caches it tracks.
+ */
+void Interconnect::clear_stats() {
+    for (Bus *bus : buses_) {
+        bus->clear_stats();
+    }
+    numa_stats_ = numa_stats_t();
+}
+
+void Interconnect::print_stats() const {
+    std::vector<bus_stats_t> banks;
+    for (ulong bank = 0; bank < config_.num_banks; bank++) {
+        banks.push_back(get_bank_stats(bank));
+    }
+    print_bank_stats(banks);
+}
+
+void Interconnect::print_numa_stats() const {
+    ::print_numa_stats(config_.num_sockets, config_.numa, numa_stats_);
+}
+
+void print_bank_stats(const std::vector<bus_stats_t> &banks) {
+
+    if (banks.size() == 1) {
+        print_bus_stats("Bus traffic (bytes)", banks[0]);
+        return;
+    }
+
+    char title[64];
+    bus_stats_t total;
+    for (ulong bank = 0; bank < banks.size(); bank++) {
+        snprintf(title, sizeof(title), "Bus traffic (bytes, bank %lu)", bank);
+        print_bus_stats(title, banks[bank]);
+        total += banks[bank];
+    }
+    print_bus_stats("Bus traffic (bytes, all banks)", total);
+}
+
+void print_numa_stats(ulong num_sockets, numa_e numa, const numa_stats_t &stats) {
+
+    const numa_stats_t &s = stats;
+    double hops_per_transaction = s.num_transactions ? (double) s.num_hops / s.num_transactions : 0.0;
+
+    std::cout << "============ NUMA coherence (" << num_sockets << " sockets, " << numa << ") ============\n";
+    printf("%-30s %14s %14s\n", "", "local", "remote");
+    printf("%-30s %14lu %14lu\n", "interventions:",   s.num_local_interventions, s.num_remote_interventions);
+    printf("%-30s %14lu %14lu\n", "flushes:",         s.num_local_flushes,       s.num_remote_flushes);
+    printf("%-30s %14lu %14lu\n", "memory accesses:", s.num_local_memory,        s.num_remote_memory);
+    printf("%-30s %29lu\n", "snooped transactions:",        s.num_transactions);
+    printf("%-30s %29lu\n", "remote socket snoops:",        s.num_remote_snoops);
+    printf("%-30s %29lu\n", "snoops filtered by directory:", s.num_filtered_snoops);
+    printf("%-30s %29lu\n", "inter-socket hops:",           s.num_hops);
+    printf("%-30s %29.2lf\n", "hops per transaction:",      hops_per_transaction);
+}
@@ -0,0 +1,107 @@
+#ifndef __INTERCONNECT_H__
+#define __INTERCONNECT_H__
+
+#include <vector>
+#include <unordered_map>
+#include "bus.h"
+#include "arena.h"
+#include "port.h"
+
+/**
+ * @brief Shape of the interconnect
+ */
+struct interconnect_config_t {
+    ulong   num_cores{4};
+    ulong   num_banks{1};     /* Address-interleaved bus banks per socket */
+    ulong   num_sockets{1};
+    numa_e  numa{numa_e::Broadcast};
+
+    /* Socket of every core. Empty to split the cores into balanced contiguous groups */
+    std::vector<ulong> socket_map;
+};
+
+/**
+ * @brief Counters of the inter-socket coherence layer.
+ * A hop is one message that crosses from one socket to another.
+ */
+struct numa_stats_t {
+    ulong num_local_interventions{0}, num_remote_interventions{0};
+    ulong num_local_flushes{0}, num_remote_flushes{0};
+    ulong num_local_memory{0}, num_remote_memory{0};
+
+    ulong num_transactions{0};      /* Snooped transactions */
+    ulong num_remote_snoops{0};     /* Socket-level snoops sent to a remote socket */
+    ulong num_filtered_snoops{0};   /* Remote snoops that the directory proved unnecessary */
+    ulong num_hops{0};
+};
+
+/**
+ * @brief A snooping interconnect made of independent bus banks.
+ * The block address space is interleaved across the banks, so that
+ * transactions to different banks never see each other. Every bank
+ * keeps its own statistics.
+ * 
+ * Cores can also be grouped into sockets. Each socket then has its own
+ * local buses, and requests reach the other sockets either by broadcast
+ * or through a directory at the home socket of the block.
+ * With a single bank and a single socket this is exactly the shared bus.
+ */
+class Interconnect : public Port<bus_transaction_t>{
+
+private:
+    interconnect_config_t config_;
+
+    /* num_sockets x num_banks buses, socket major */
+    std::vector<Bus*> buses_;
+    ulong num_block_offset_bits_;
+    std::vector<ulong> socket_of_;
+
+    /* Directory: block address -> bit mask of the sockets that may hold a copy */
+    std::unordered_map<ulong, ulong> presence_;
+
+    numa_stats_t numa_stats_;
+
+    ulong get_block(ulong addr) const      { return addr >> num_block_offset_bits_; }
+    ulong get_socket(ulong core) const     { return socket_of_[core]; }
+    ulong get_home(ulong addr) const       { return get_block(addr) % config_.num_sockets; }
+
+    Bus *get_bus(ulong socket, ulong addr) const {
+        return buses_[socket * config_.num_banks + get_block(addr) % config_.num_banks];
+    }
+
+    void snoop_socket(ulong socket, bus_transaction_t &trans, bool remote);
+    bool socket_has_copy(ulong socket, const bus_transaction_t &trans);
+    void access_memory(ulong socket, ulong addr, bool at_home = false);
+    void receive_numa(bus_transaction_t &trans);
+
+public:
+    Interconnect(const interconnect_config_t &config, const bus_config_t &bus_config, Arena &arena);
+    ~Interconnect();
+
+    /* Connect a cache to the snoop fan-out of every bank of its socket */
+    void attach(Port<bus_transaction_t> *cache, ulong core);
+
+    /* Put a main memory model behind every bus */
+    void set_memory(Dram *memory);
+
+    /* Let every bus count its snoop fan-out */
+    void set_profiler(Profiler *profiler);
+
+    void receive(bus_transaction_t &trans) override;
+    void respond(bus_transaction_t &trans) override;
+
+    ulong get_num_banks() const                 { return config_.num_banks; }
+    ulong get_num_sockets() const               { return config_.num_sockets; }
+    const numa_stats_t &get_numa_stats() const  { return numa_stats_; }
+    bus_stats_t get_stats() const;
+    bus_stats_t get_bank_stats(ulong bank) const;
+    void clear_stats();
+    void print_stats() const;
+    void print_numa_stats() const;
+};
+
+/* Print a snapshot of the traffic of every bank, and of all the banks together when there are several */
+void print_bank_stats(const std::vector<bus_stats_t> &banks);
+void print_numa_stats(ulong num_sockets, numa_e numa, const numa_stats_t &stats);
+
+#endif /* __INTERCONNECT_H__ */
@@ -7,73 +7,566 @@
 #include <iomanip>
 #include <assert.h>
 #include <fstream>
+#include <atomic>
+#include <new>
 using namespace std;
 
-#include "cache.h"
-#include "bus.h"
+#include "system.h"
+#include "result_cache.h"
+#include "progress.h"
+#include "outcome.h"
+#include "profile.h"
+#include "trace.h"
 
 #define TRACE_CONFIG(s, d) \
    do { \
       printf("%-25s %lu\n", s, d); \
    } while(0)
 
+/* Heap allocations of the whole program for --alloc-stats, the arena only counts its own */
+static std::atomic<ulong> num_heap_allocations{0};
+
+void *operator new(size_t size) {
+    num_heap_allocations.fetch_add(1, std::memory_order_relaxed);
+    void *ptr = malloc(size ? size : 1);
+    if (ptr == NULL) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void operator delete(void *ptr) noexcept {
+    free(ptr);
+}
+
+/**
+ * @brief Match an option of the form --name=value and parse its value
+ * 
+ * @return true if `arg` is the option `name`
+ */
+static bool parse_option(const std::string &arg, const std::string &name, ulong &value) {
+    if (arg.compare(0, name.size() + 1, name + "=") != 0) {
+        return false;
+    }
+    char *end;
+    const char *str = arg.c_str() + name.size() + 1;
+    value = strtoul(str, &end, 0);
+    if (*str == '\0' || *end != '\0') {
+        fprintf(stderr, "ERROR: Invalid value for option %s\n", arg.c_str());
+        exit(EXIT_FAILURE);
+    }
+    return true;
+}
+
+/**
+ * @brief Match an option of the form --name=value and parse its value as a number with a fraction
+ */
+static bool parse_option(const std::string &arg, const std::string &name, double &value) {
+    if (arg.compare(0, name.size() + 1, name + "=") != 0) {
+        return false;
+    }
+    char *end;
+    const char *str = arg.c_str() + name.size() + 1;
+    value = strtod(str, &end);
+    if (*str == '\0' || *end != '\0') {
+        fprintf(stderr, "ERROR: Invalid value for option %s\n", arg.c_str());
+        exit(EXIT_FAILURE);
+    }
+    return true;
+}
+
+/**
+ * @brief Match an option of the form --name=value and return its value as a string
+ */
+static bool parse_option(const std::string &arg, const std::string &name, std::string &value) {
+    if (arg.compare(0, name.size() + 1, name + "=") != 0) {
+        return false;
+    }
+    value = arg.substr(name.size() + 1);
+    return true;
+}
+
+/**
+ * @brief Parse a comma separated list of cores, e.g. 0,2,3
+ */
+static std::vector<ulong> parse_cores(const std::string &list, ulong num_processors) {
+    std::vector<ulong> cores;
+    std::stringstream ss(list);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        char *end;
+        ulong core = strtoul(item.c_str(), &end, 10);
+        if (item.empty() || *end != '\0' || core >= num_processors) {
+            fprintf(stderr, "ERROR: Invalid core %s\n", item.c_str());
+            exit(EXIT_FAILURE);
+        }
+        cores.push_back(core);
+    }
+    return cores;
+}
+
+/**
+ * @brief Place the cores on the sockets: compact fills the sockets with contiguous
+ * cores, scatter deals the cores out round-robin, or a comma separated list gives
+ * the socket of every core, e.g. 0,1,1,0
+ */
+static std::vector<ulong> parse_socket_map(const std::string &map, ulong num_processors, ulong num_sockets) {
+    std::vector<ulong> sockets;
+    if (map == "compact") {
+        return sockets;
+    }
+    if (map == "scatter") {
+        for (ulong core = 0; core < num_processors; core++) {
+            sockets.push_back(core % num_sockets);
+        }
+        return sockets;
+    }
+    std::stringstream ss(map);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        char *end;
+        ulong socket = strtoul(item.c_str(), &end, 10);
+        if (item.empty() || *end != '\0' || socket >= num_sockets) {
+            fprintf(stderr, "ERROR: Invalid socket %s\n", item.c_str());
+            exit(EXIT_FAILURE);
+        }
+        sockets.push_back(socket);
+    }
+    if (sockets.size() != num_processors) {
+        fprintf(stderr, "ERROR: The socket map needs one socket per core\n");
+        exit(EXIT_FAILURE);
+    }
+    return sockets;
+}
+
+/* Number of references read from the trace before they are handed to the simulator */
+#define BATCH_SIZE 4096
+
 
 int main(int argc, char *argv[]) {
     
     if(argv[1] == NULL){
          fprintf(stderr, "input format: ");
-         fprintf(stderr, "./smp_cache <cache_size> <assoc> <block_size> <num_processors> <protocol> <trace_file> \n");
+         fprintf(stderr, "./smp_cache <cache_size> <assoc> <block_size> <num_processors> <protocol> <trace_file> [options]\n");
+         fprintf(stderr, "options:\n");
+         fprintf(stderr, "  --sparse        allocate cache sets on first touch instead of up front\n");
+         fprintf(stderr, "  --index=F       set index function modulo|xor|prime|skewed (default modulo)\n");
+         fprintf(stderr, "  --alloc-stats   report the simulator's own memory allocations\n");
+         fprintf(stderr, "  --bus-stats     report bytes on the bus per transaction type and per core\n");
+         fprintf(stderr, "  --bus-interval=N  with --ipc or --dram-timed, also report bus bytes per N cycles (default 10000)\n");
+         fprintf(stderr, "  --addr-bytes=N  size of the address/command phase of a bus transaction (default 8)\n");
+         fprintf(stderr, "  --word-bytes=N  widest word carried by a BusUpd (default 8)\n");
+         fprintf(stderr, "  --banks=K       interleave block addresses across K snooping bus banks (default 1)\n");
+         fprintf(stderr, "  --sockets=S     split the cores into S sockets with their own buses (default 1)\n");
+         fprintf(stderr, "  --socket-map=M  place the cores compact|scatter or on a list of sockets, e.g. 0,1,1,0 (default compact)\n");
+         fprintf(stderr, "  --directory     reach remote sockets through a home directory instead of broadcast\n");
+         fprintf(stderr, "  --prefetch=P    attach a none|next-line|stride|stream prefetcher to every cache\n");
+         fprintf(stderr, "  --prefetch-degree=N  blocks fetched per prefetch trigger (default 1)\n");
+         fprintf(stderr, "  --victim-cache=N     add an N entry fully associative victim cache to every cache\n");
+         fprintf(stderr, "  --wb-buffer=N        buffer up to N dirty evictions before writing them back\n");
+         fprintf(stderr, "  --dram-channels=N    model N channels of DRAM behind the interconnect (default 0: not modeled)\n");
+         fprintf(stderr, "  --dram-banks=N       banks per DRAM channel (default 8)\n");
+         fprintf(stderr, "  --dram-policy=P      open|closed row buffer policy (default open)\n");
+         fprintf(stderr, "  --dram-timed         queue DRAM accesses and schedule them FR-FCFS instead of serving them on arrival\n");
+         fprintf(stderr, "  --dram-cycles-per-ref=N  memory cycles between two references of a core in timed mode, without --ipc (default 4)\n");
+         fprintf(stderr, "  --quantum=Q          replay in epochs of Q references where cores run their local hits ahead of the bus (default 0: exact)\n");
+         fprintf(stderr, "  --threads=N          replay the epochs of --quantum on N threads, the results do not depend on N (default 1)\n");
+         fprintf(stderr, "  --ipc=X              time the cores, issuing X instructions per cycle between the references (default 0: untimed)\n");
+         fprintf(stderr, "  --mshrs=N            misses a timed core can have outstanding (default 8)\n");
+         fprintf(stderr, "  --upgrade-latency=N  core cycles of a hit that needs the bus for its permission (default 10)\n");
+         fprintf(stderr, "  --remote-latency=N   core cycles of a miss that another cache supplies (default 40)\n");
+         fprintf(stderr, "  --memory-latency=N   core cycles of a miss that memory supplies (default 100)\n");
+         fprintf(stderr, "  --skip=N             skip the first N references of the trace (of the ROI with --roi)\n");
+         fprintf(stderr, "  --limit=N            simulate at most N references\n");
+         fprintf(stderr, "  --warmup=N           replay the N references before the window to warm the caches, without statistics\n");
+         fprintf(stderr, "  --roi                only simulate between the ROI begin (b) and end (e) markers of the trace\n");
+         fprintf(stderr, "  --cores=LIST         only replay the references of the cores in LIST, e.g. 0,2\n");
+         fprintf(stderr, "  --result-cache=DIR   reuse the results of identical earlier runs stored in DIR\n");
+         fprintf(stderr, "  --progress=PATH      publish live progress in a shared page at PATH (see tools/smp_progress)\n");
+         fprintf(stderr, "  --profile[=N]        time the phases of the simulator on 1 in N accesses (default %d) and report snoop fan-out\n", PROFILE_PERIOD);
+         fprintf(stderr, "  --outcomes=PATH      write the outcome of every reference to PATH (see tools/smp_outcomes)\n");
          exit(EXIT_FAILURE);
     }
 
-    ulong cache_size        = atoi(argv[1]);
-    ulong cache_assoc       = atoi(argv[2]);
-    ulong blk_size          = atoi(argv[3]);
-    ulong num_processors    = atoi(argv[4]);
-    protocol_e protocol     = static_cast<protocol_e>(atoi(argv[5]));
-    char *fname             = new char[20];
-    fname                   = argv[6];
+    system_config_t config;
+    config.cache_size       = atoi(argv[1]);
+    config.assoc            = atoi(argv[2]);
+    config.block_size       = atoi(argv[3]);
+    config.num_processors   = atoi(argv[4]);
+    config.protocol         = static_cast<protocol_e>(atoi(argv[5]));
+    char *fname             = argv[6];
 
-    FILE *trace = fopen (fname, "r");
-    if(!trace) {   
-        fprintf(stderr, "ERROR: Unable to open trace file %s\n", fname);
+    bool alloc_stats        = false;
+    bool bus_stats          = false;
+    std::string result_dir;
+    std::string progress_path;
+    std::string outcome_path;
+    ulong profile_period    = 0;
+    ulong num_threads       = 1;
+    std::string socket_map;
+    trace_window_t window;
+    std::string value;
+
+    /* Optional flags follow the positional arguments */
+    for (int i = 7; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--sparse") {
+            config.storage = storage_e::Sparse;
+        }
+        else if (parse_option(arg, "--index", value)) {
+            if      (value == "modulo")     config.set_index = index_e::Modulo;
+            else if (value == "xor")        config.set_index = index_e::XorFold;
+            else if (value == "prime")      config.set_index = index_e::PrimeModulo;
+            else if (value == "skewed")     config.set_index = index_e::Skewed;
+            else {
+                fprintf(stderr, "ERROR: Unknown index function %s\n", value.c_str());
+                exit(EXIT_FAILURE);
+            }
+        }
+        else if (arg == "--alloc-stats") {
+            alloc_stats = true;
+        }
+        else if (arg == "--bus-stats") {
+            bus_stats = true;
+        }
+        else if (parse_option(arg, "--bus-interval", config.bus_interval)) {
+            if (config.bus_interval == 0) {
+                fprintf(stderr, "ERROR: The bus interval must be at least one cycle\n");
+                exit(EXIT_FAILURE);
+            }
+        }
+        else if (parse_option(arg, "--addr-bytes", config.addr_bytes)) {}
+        else if (parse_option(arg, "--word-bytes", config.word_bytes)) {}
+        else if (parse_option(arg, "--banks", config.num_banks)) {}
+        else if (parse_option(arg, "--sockets", config.num_sockets)) {}
+        else if (parse_option(arg, "--socket-map", socket_map)) {}
+        else if (arg == "--directory") {
+            config.numa = numa_e::Directory;
+        }
+        else if (parse_option(arg, "--prefetch", value)) {
+            if      (value == "none")       config.prefetcher = prefetcher_e::None;
+            else if (value == "next-line")  config.prefetcher = prefetcher_e::NextLine;
+            else if (value == "stride")     config.prefetcher = prefetcher_e::Stride;
+            else if (value == "stream")     config.prefetcher = prefetcher_e::Stream;
+            else {
+                fprintf(stderr, "ERROR: Unknown prefetcher %s\n", value.c_str());
+                exit(EXIT_FAILURE);
+            }
+        }
+        else if (parse_option(arg, "--prefetch-degree", config.prefetch_degree)) {}
+        else if (parse_option(arg, "--victim-cache", config.victim_entries)) {}
+        else if (parse_option(arg, "--wb-buffer", config.wb_buffer_entries)) {}
+        else if (parse_option(arg, "--dram-channels", config.dram_channels)) {}
+        else if (parse_option(arg, "--dram-banks", config.dram_banks)) {}
+        else if (parse_option(arg, "--dram-policy", value)) {
+            if      (value == "open")   config.dram_policy = dram_policy_e::Open;
+            else if (value == "closed") config.dram_policy = dram_policy_e::Closed;
+            else {
+                fprintf(stderr, "ERROR: Unknown DRAM policy %s\n", value.c_str());
+                exit(EXIT_FAILURE);
+            }
+        }
+        else if (arg == "--dram-timed") {
+            config.dram_mode = dram_mode_e::Timed;
+        }
+        else if (parse_option(arg, "--dram-cycles-per-ref", config.dram_cycles_per_ref)) {}
+        else if (parse_option(arg, "--quantum", config.quantum)) {}
+        else if (parse_option(arg, "--threads", num_threads)) {
+            if (num_threads == 0) {
+                fprintf(stderr, "ERROR: At least one thread is needed\n");
+                exit(EXIT_FAILURE);
+            }
+        }
+        else if (parse_option(arg, "--ipc", config.ipc)) {
+            if (!(config.ipc > 0.0)) {
+                fprintf(stderr, "ERROR: The IPC must be positive\n");
+                exit(EXIT_FAILURE);
+            }
+        }
+        else if (parse_option(arg, "--mshrs", config.mshrs)) {
+            if (config.mshrs == 0) {
+                fprintf(stderr, "ERROR: At least one MSHR is needed\n");
+                exit(EXIT_FAILURE);
+            }
+        }
+        else if (parse_option(arg, "--upgrade-latency", config.upgrade_latency)) {}
+        else if (parse_option(arg, "--remote-latency", config.remote_latency)) {}
+        else if (parse_option(arg, "--memory-latency", config.memory_latency)) {}
+        else if (parse_option(arg, "--skip", window.skip)) {}
+        else if (parse_option(arg, "--limit", window.limit)) {}
+        else if (parse_option(arg, "--warmup", window.warmup)) {}
+        else if (arg == "--roi") {
+            window.roi = true;
+        }
+        else if (parse_option(arg, "--cores", value)) {
+            window.cores = parse_cores(value, config.num_processors);
+        }
+        else if (parse_option(arg, "--result-cache", result_dir)) {}
+        else if (parse_option(arg, "--progress", progress_path)) {}
+        else if (parse_option(arg, "--outcomes", outcome_path)) {}
+        else if (arg == "--profile") {
+            profile_period = PROFILE_PERIOD;
+        }
+        else if (parse_option(arg, "--profile", profile_period)) {
+            if (profile_period == 0) {
+                fprintf(stderr, "ERROR: The profile period must be at least 1\n");
+                exit(EXIT_FAILURE);
+            }
+        }
+        else {
+            fprintf(stderr, "ERROR: Unknown option %s\n", argv[i]);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    /* The map depends on the number of sockets, which may come after it */
+    if (!socket_map.empty()) {
+        config.socket_map = parse_socket_map(socket_map, config.num_processors, config.num_sockets);
+    }
+
+    if (num_threads > 1 && config.quantum == 0) {
+        fprintf(stderr, "ERROR: --threads only applies to the epochs of --quantum\n");
         exit(EXIT_FAILURE);
     }
 
+    TraceReader trace(fname);
+
     printf("===== 506 Personal information =====\n");
     printf("Name: Santosh Srivatsan\n");
     printf("UnityID: srsrivat\n");
     printf("ECE492 student? No\n");
 
     printf("===== 506 SMP Simulator configuration =====\n");
-    TRACE_CONFIG("L1_SIZE:", cache_size);
-    TRACE_CONFIG("L1_ASSOC:", cache_assoc);
-    TRACE_CONFIG("L1_BLOCKSIZE:", blk_size);
-    TRACE_CONFIG("NUMBER OF PROCESSORS:", num_processors);
-    std::cout<<std::setw(25)<<std::left<<"COHERENCE PROTOCOL: "<< protocol<<'\n';
+    TRACE_CONFIG("L1_SIZE:", config.cache_size);
+    TRACE_CONFIG("L1_ASSOC:", config.assoc);
+    TRACE_CONFIG("L1_BLOCKSIZE:", config.block_size);
+    TRACE_CONFIG("NUMBER OF PROCESSORS:", config.num_processors);
+    std::cout<<std::setw(25)<<std::left<<"COHERENCE PROTOCOL: "<< config.protocol<<'\n';
     printf("TRACE FILE: %s\n", fname);
+    if (config.num_banks != 1) {
+        TRACE_CONFIG("BUS BANKS:", config.num_banks);
+    }
+    if (config.num_sockets != 1) {
+        TRACE_CONFIG("SOCKETS:", config.num_sockets);
+        std::cout<<std::setw(25)<<std::left<<"INTER-SOCKET COHERENCE: "<< config.numa<<'\n';
+        if (!config.socket_map.empty()) {
+            printf("%-25s", "SOCKET MAP:");
+            for (ulong socket : config.socket_map) {
+                printf(" %lu", socket);
+            }
+            printf("\n");
+        }
+    }
+    if (config.prefetcher != prefetcher_e::None) {
+        std::cout<<std::setw(25)<<std::left<<"PREFETCHER: "<< config.prefetcher<<'\n';
+        TRACE_CONFIG("PREFETCH DEGREE:", config.prefetch_degree);
+    }
+    if (config.victim_entries != 0) {
+        TRACE_CONFIG("VICTIM CACHE ENTRIES:", config.victim_entries);
+    }
+    if (config.wb_buffer_entries != 0) {
+        TRACE_CONFIG("WB BUFFER ENTRIES:", config.wb_buffer_entries);
+    }
+    if (config.storage != storage_e::Dense) {
+        std::cout<<std::setw(25)<<std::left<<"SET STORAGE: "<< config.storage<<'\n';
+    }
+    if (config.set_index != index_e::Modulo) {
+        std::cout<<std::setw(25)<<std::left<<"SET INDEX: "<< config.set_index<<'\n';
+    }
+    if (config.dram_channels != 0) {
+        TRACE_CONFIG("DRAM CHANNELS:", config.dram_channels);
+        TRACE_CONFIG("DRAM BANKS:", config.dram_banks);
+        std::cout<<std::setw(25)<<std::left<<"DRAM ROW POLICY: "<< config.dram_policy<<'\n';
+        std::cout<<std::setw(25)<<std::left<<"DRAM MODE: "<< config.dram_mode<<'\n';
+        if (config.dram_mode == dram_mode_e::Timed) {
+            TRACE_CONFIG("DRAM CYCLES PER REF:", config.dram_cycles_per_ref);
+        }
+    }
+    if (config.quantum != 0) {
+        TRACE_CONFIG("EPOCH QUANTUM:", config.quantum);
+    }
+    if (config.ipc > 0.0) {
+        printf("%-25s %.2lf\n", "CORE IPC:", config.ipc);
+        TRACE_CONFIG("MSHRS PER CORE:", config.mshrs);
+        TRACE_CONFIG("UPGRADE LATENCY:", config.upgrade_latency);
+        TRACE_CONFIG("REMOTE LATENCY:", config.remote_latency);
+        TRACE_CONFIG("MEMORY LATENCY:", config.memory_latency);
+    }
+    if (window.roi) {
+        printf("%-25s %s\n", "REGION OF INTEREST:", "markers");
+    }
+    if (window.skip != 0) {
+        TRACE_CONFIG("SKIPPED REFERENCES:", window.skip);
+    }
+    if (window.limit != 0) {
+        TRACE_CONFIG("REFERENCE LIMIT:", window.limit);
+    }
+    if (window.warmup != 0) {
+        TRACE_CONFIG("WARM-UP REFERENCES:", window.warmup);
+    }
+    if (!window.cores.empty()) {
+        printf("%-25s", "REPLAYED CORES:");
+        for (ulong core : window.cores) {
+            printf(" %lu", core);
+        }
+        printf("\n");
+    }
+
+    /**
+     * Identical runs are served from the result cache. The allocation statistics
+     * and the profile describe the simulator itself rather than the simulated system,
+     * and the outcome stream needs the replay, so asking for any of them always runs the simulation.
+     */
+    ResultCache results(result_dir);
+    ulong trace_hash = 0;
+    if (!result_dir.empty()) {
+        trace_hash = ResultCache::hash_trace(fname);
+
+        system_stats_t stats;
+        if (!alloc_stats && !profile_period && outcome_path.empty() && results.load(trace_hash, config, window, stats)) {
+            System::print_stats(config, stats);
+            if (bus_stats) {
+                System::print_bus_stats(config, stats);
+            }
+            return 0;
+        }
+    }
+
+    ulong heap_start = num_heap_allocations;
+    System system(config);
+    ulong heap_built = num_heap_allocations;
+    system.set_num_threads(num_threads);
+
+    OutcomeWriter *outcomes = NULL;
+    if (!outcome_path.empty()) {
+        outcomes = new OutcomeWriter(outcome_path, config.num_processors, config.block_size, config.protocol);
+    }
+
+    Profiler *profiler = NULL;
+    if (profile_period) {
+        profiler = new Profiler(config.num_processors, profile_period);
+        system.set_profiler(profiler);
+    }
+
+    /* The progress page is updated between batches, never from the access path */
+    ProgressPage *progress = NULL;
+    if (!progress_path.empty()) {
+        progress = new ProgressPage(progress_path, config.num_processors, trace.size());
+    }
+
+    /* Only part of the trace is replayed, look it up in the index */
+    trace_range_t range;
+    if (window.needs_index()) {
+        trace_index_t index;
+        if (!index.load(fname)) {
+            fprintf(stderr, "Indexing %s, run tools/smp_index to keep the index\n", fname);
+            index = trace.build_index();
+        }
+        range = resolve_window(window, index);
+        trace.seek(index, range.warmup_begin);
+    }
+    else if (window.limit != 0) {
+        range.end = window.limit;
+    }
+
+    std::vector<bool> replayed(config.num_processors, window.cores.empty());
+    for (ulong core : window.cores) {
+        replayed[core] = true;
+    }
+    bool warming_up = (range.warmup_begin < range.begin);
+
+    /* The outcome stream only records the measured references, like the counters */
+    ulong num_warmup_refs = 0;
+    if (outcomes && !warming_up) {
+        system.set_outcome_stream(outcomes);
+    }
+
+    std::vector<access_t> batch;
+    batch.reserve(BATCH_SIZE);
+
+    /* With --profile, the time between two batches is spent reading the trace */
+    ulong parse_start = read_cycles();
+    auto replay_batch = [&]() {
+        if (profiler) {
+            profiler->add(phase_e::Parse, read_cycles() - parse_start, batch.size());
+        }
+        system.access(batch);
+        batch.clear();
+        if (profiler) {
+            parse_start = read_cycles();
+        }
+    };
 
-    Bus *bus = new Bus();
-    std::vector<Cache*> caches(num_processors);
+    trace_record_t record;
 
-    for(uint i = 0; i < num_processors; i++) {
-        caches[i] = new Cache(i, cache_size, cache_assoc, blk_size, protocol);
-        /* Two way communication between the cache and the bus */
-        caches[i]->connect(bus);
-        bus->connect(caches[i]);
+    while (trace.get_num_refs() < range.end && trace.next(record)) {
+        if (record.kind != record_e::Access) {
+            continue;
+        }
+
+        /* The counters restart right before the first measured reference */
+        if (warming_up && trace.get_num_refs() > range.begin) {
+            replay_batch();
+            system.clear_stats();
+            if (outcomes) {
+                system.set_outcome_stream(outcomes);
+            }
+            num_warmup_refs = system.get_num_accesses();
+            warming_up = false;
+        }
+
+        /* References of unknown cores go through, the system rejects them */
+        uint core = record.access.core;
+        if (core < replayed.size() && !replayed[core]) {
+            continue;
+        }
+
+        batch.push_back(record.access);
+        if (batch.size() == BATCH_SIZE) {
+            replay_batch();
+            if (progress) {
+                progress->update(system, trace.tell(), warming_up ? system.get_num_accesses() : num_warmup_refs);
+            }
+        }
+    }
+    replay_batch();
+    system.sync();
+    if (warming_up) {
+        system.clear_stats();
+        num_warmup_refs = system.get_num_accesses();
+    }
+    if (progress) {
+        progress->update(system, trace.tell(), num_warmup_refs, true);
+        delete progress;
     }
 
-    ulong proc;
-    op_e op;
-    ulong addr;
+    if (outcomes) {
+        system.set_outcome_stream(NULL);
+        delete outcomes;
+    }
+
+    ulong stats_start = read_cycles();
 
-    while(fscanf(trace, "%lu %c %lx", &proc, &op, &addr) != EOF) {
-        caches[proc]->Access(addr, op);
+    if (!result_dir.empty()) {
+        results.store(trace_hash, config, window, system.get_system_stats());
+    }
+
+    system.print_stats();
+    if (bus_stats) {
+        system.print_bus_stats();
+    }
+    if (alloc_stats) {
+        ulong heap_end = num_heap_allocations;
+        system.print_alloc_stats();
+        printf("%-45s %lu\n", "heap allocations building the system:",  heap_built - heap_start);
+        printf("%-45s %lu\n", "heap allocations after it was built:",   heap_end - heap_built);
     }
-    fclose(trace);
 
-    for (int i = 0; i < num_processors; i++) {
-        caches[i]->print_stats();
+    if (profiler) {
+        profiler->add(phase_e::Stats, read_cycles() - stats_start);
+        profiler->print();
+        system.set_profiler(NULL);
+        delete profiler;
     }
 
     return 0;
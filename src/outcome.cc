@@ -0,0 +1,72 @@
+#include <stdlib.h>
+#include <string.h>
+#include <iostream>
+#include "outcome.h"
+
+OutcomeWriter::OutcomeWriter(const std::string &path, ulong num_cores, ulong block_size, protocol_e protocol)
+: buffer_ (BUFFER_RECORDS)
+{
+   file_ = fopen(path.c_str(), "wb");
+   if (!file_) {
+      FATAL(": Unable to create outcome stream " << path);
+   }
+
+   outcome_header_t header;
+   memset(&header, 0, sizeof(header));
+   header.magic        = OUTCOME_MAGIC;
+   header.version      = OUTCOME_VERSION;
+   header.record_size  = sizeof(outcome_record_t);
+   header.num_cores    = num_cores;
+   header.block_size   = block_size;
+   header.protocol     = protocol;
+
+   if (fwrite(&header, sizeof(header), 1, file_) != 1) {
+      FATAL(": Unable to write outcome stream " << path);
+   }
+}
+
+OutcomeWriter::~OutcomeWriter() {
+   flush();
+   fclose(file_);
+}
+
+void OutcomeWriter::flush() {
+   if (count_ > 0 && fwrite(buffer_.data(), sizeof(outcome_record_t), count_, file_) != count_) {
+      FATAL(": Unable to write outcome stream");
+   }
+   count_ = 0;
+}
+
+/******************************************************************/
+
+OutcomeReader::OutcomeReader(const std::string &path)
+: buffer_ (16384)
+{
+   file_ = fopen(path.c_str(), "rb");
+   if (!file_) {
+      FATAL(": Unable to open outcome stream " << path);
+   }
+
+   if (fread(&header_, sizeof(header_), 1, file_) != 1 || header_.magic != OUTCOME_MAGIC) {
+      FATAL(": " << path << " is not an outcome stream");
+   }
+   if (header_.version != OUTCOME_VERSION || header_.record_size != sizeof(outcome_record_t)) {
+      FATAL(": " << path << " was written by an incompatible version of the simulator");
+   }
+}
+
+OutcomeReader::~OutcomeReader() {
+   fclose(file_);
+}
+
+bool OutcomeReader::next(outcome_record_t &record) {
+   if (next_ == count_) {
+      count_ = fread(buffer_.data(), sizeof(outcome_record_t), buffer_.size(), file_);
+      next_  = 0;
+      if (count_ == 0) {
+         return false;
+      }
+   }
+   record = buffer_[next_++];
+   return true;
+}
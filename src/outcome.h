@@ -0,0 +1,105 @@
+#ifndef __OUTCOME_H__
+#define __OUTCOME_H__
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include "types.h"
+
+#define OUTCOME_MAGIC     0x4f504d53UL    /* "SMPO" */
+#define OUTCOME_VERSION   1
+
+/* Flags of an outcome record */
+static const uint8_t OUTCOME_HIT            = 1 << 0;  /* The block was in the cache (or in its victim cache) */
+static const uint8_t OUTCOME_VICTIM_HIT     = 1 << 1;  /* The block was recovered from the victim cache */
+static const uint8_t OUTCOME_PREFETCH_HIT   = 1 << 2;  /* First demand for a prefetched block */
+static const uint8_t OUTCOME_EVICTION       = 1 << 3;  /* The fill evicted a valid block, see victim_addr */
+static const uint8_t OUTCOME_WRITE_BACK     = 1 << 4;  /* The evicted block was dirty */
+
+/**
+ * @brief Header at the start of an outcome stream
+ */
+struct outcome_header_t {
+   uint32_t magic;
+   uint32_t version;
+   uint32_t record_size;
+   uint32_t num_cores;
+   ulong    block_size;
+   uint8_t  protocol;       /* protocol_e */
+   uint8_t  reserved[7];
+};
+
+/**
+ * @brief What happened to a single demand reference, in trace order.
+ * Prefetches issued behind a reference are not recorded.
+ */
+struct outcome_record_t {
+   ulong    addr;
+   ulong    victim_addr;         /* Address of the evicted block, if OUTCOME_EVICTION */
+   uint32_t core;
+   uint8_t  op;                  /* op_e of the trace, 'r', 'w' or 'a'. Fences are not recorded */
+   uint8_t  flags;               /* OUTCOME_* */
+   uint8_t  state_before;        /* state_e */
+   uint8_t  state_after;
+   uint8_t  signals;             /* Bit (1 << bus_signal_e) for every signal the requester issued */
+   uint8_t  num_invalidations;   /* Snoop responses to the request, saturated at 255 */
+   uint8_t  num_interventions;
+   uint8_t  num_flushes;
+   uint8_t  reserved[4];
+};
+
+static_assert(sizeof(outcome_record_t) == 32, "Outcome records are meant to stay 32 bytes");
+
+/**
+ * @brief Buffered writer of an outcome stream. Records are appended to
+ * a buffer in memory and written out a large block at a time.
+ */
+class OutcomeWriter {
+private:
+   static const size_t BUFFER_RECORDS = 16384;
+
+   FILE *file_{nullptr};
+   std::vector<outcome_record_t> buffer_;
+   size_t count_{0};
+
+   void flush();
+
+public:
+   OutcomeWriter(const std::string &path, ulong num_cores, ulong block_size, protocol_e protocol);
+   ~OutcomeWriter();
+
+   OutcomeWriter(const OutcomeWriter &) = delete;
+   OutcomeWriter &operator=(const OutcomeWriter &) = delete;
+
+   void append(const outcome_record_t &record) {
+      buffer_[count_++] = record;
+      if (count_ == BUFFER_RECORDS) {
+         flush();
+      }
+   }
+};
+
+/**
+ * @brief Buffered reader of an outcome stream
+ */
+class OutcomeReader {
+private:
+   FILE *file_{nullptr};
+   outcome_header_t header_;
+   std::vector<outcome_record_t> buffer_;
+   size_t count_{0}, next_{0};
+
+public:
+   explicit OutcomeReader(const std::string &path);
+   ~OutcomeReader();
+
+   OutcomeReader(const OutcomeReader &) = delete;
+   OutcomeReader &operator=(const OutcomeReader &) = delete;
+
+   const outcome_header_t &get_header() const { return header_; }
+
+   /* Return false at the end of the stream */
+   bool next(outcome_record_t &record);
+};
+
+#endif /* __OUTCOME_H__ */
@@ -2,6 +2,7 @@
 #define __PORT_H__
 
 #include <vector>
+#include <stddef.h>
 
 /**
  * Facilitate two way communication between objects.
@@ -16,23 +17,24 @@ private:
 
 public:
     Port() {}
+    virtual ~Port() = default;
 
     /* Connect the port to another port */
     void connect(Port<T> *port) {
         ports_.push_back(port);
     }
 
-    int get_num_ports() {
+    size_t get_num_ports() {
         return ports_.size();
     }
 
     /* Send a transaction over the first connected port */
-    void send(const T &trans) {
+    void send(T &trans) {
         ports_[0]->receive(trans);
     }
 
     /* Send a transcation over a specific port */
-    void send(uint32_t port_id, const T &trans) {
+    void send(uint32_t port_id, T &trans) {
         ports_[port_id]->receive(trans);
     }
 
@@ -46,8 +48,11 @@ public:
         ports_[port_id]->respond(trans);
     }
 
-    /* The receiver decides how it wants to handle the sent transaction */
-    virtual void receive (const T &trans) = 0;
+    /**
+     * The receiver decides how it wants to handle the sent transaction.
+     * It may annotate the transaction with its response (e.g. a flush)
+    */
+    virtual void receive (T &trans) = 0;
 
     /* The receiver decides how it wants to handle the requested transaction */
     virtual void respond (T &trans) = 0;
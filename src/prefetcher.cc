@@ -0,0 +1,148 @@
+#include <stdlib.h>
+#include <iostream>
+#include "prefetcher.h"
+
+/**
+ * @brief Fetch the `degree` blocks that follow every miss
+ */
+class PrefetcherNextLine : public Prefetcher {
+
+public:
+    using Prefetcher::Prefetcher;
+
+    void observe(ulong addr, bool miss, std::vector<ulong> &candidates) override {
+        if (!miss) {
+            return;
+        }
+        ulong block = addr / block_size_;
+        for (ulong i = 1; i <= degree_; i++) {
+            candidates.push_back((block + i) * block_size_);
+        }
+    }
+};
+
+/**
+ * @brief The trace has no PCs, so strides are tracked per memory region instead of per instruction.
+ * A region needs to see the same stride twice in a row before it is trusted.
+ */
+class PrefetcherStride : public Prefetcher {
+
+private:
+    static const ulong NUM_ENTRIES  = 64;
+    static const ulong REGION_BITS  = 12;
+
+    struct entry_t {
+        ulong region{~0UL};
+        ulong last_addr{0};
+        long  stride{0};
+        bool  confirmed{false};
+    };
+    entry_t table_[NUM_ENTRIES];
+
+public:
+    using Prefetcher::Prefetcher;
+
+    void observe(ulong addr, bool miss, std::vector<ulong> &candidates) override {
+        ulong region = addr >> REGION_BITS;
+        entry_t &entry = table_[region % NUM_ENTRIES];
+
+        if (entry.region != region) {
+            entry = entry_t();
+            entry.region    = region;
+            entry.last_addr = addr;
+            return;
+        }
+
+        long stride = (long) (addr - entry.last_addr);
+        entry.confirmed = (stride != 0 && stride == entry.stride);
+        entry.stride    = stride;
+        entry.last_addr = addr;
+
+        /* Strides within a block would only prefetch the block we already have */
+        if (!entry.confirmed || (ulong) labs(stride) < block_size_) {
+            return;
+        }
+        for (ulong i = 1; i <= degree_; i++) {
+            candidates.push_back(addr + i * stride);
+        }
+    }
+};
+
+/**
+ * @brief Track a few streams of misses to consecutive blocks, in either direction.
+ * Once a stream has seen two consecutive blocks, each new block in it pulls in
+ * the next `degree` blocks of the stream.
+ */
+class PrefetcherStream : public Prefetcher {
+
+private:
+    static const ulong NUM_STREAMS = 8;
+    static const long  WINDOW      = 4;   /* How far from the head of a stream a block may land and still extend it */
+
+    struct stream_t {
+        ulong head{0};
+        long  direction{0};
+        ulong lru{0};
+        bool  valid{false};
+    };
+    stream_t streams_[NUM_STREAMS];
+    ulong clock_{0};
+
+public:
+    using Prefetcher::Prefetcher;
+
+    void observe(ulong addr, bool miss, std::vector<ulong> &candidates) override {
+        if (!miss) {
+            return;
+        }
+
+        ulong block = addr / block_size_;
+        clock_++;
+
+        stream_t *victim = &streams_[0];
+        for (stream_t &stream : streams_) {
+            if (!stream.valid) {
+                victim = &stream;
+                continue;
+            }
+
+            long distance = (long) (block - stream.head);
+            bool extends = (stream.direction == 0) ? (distance != 0 && labs(distance) <= WINDOW)
+                                                   : (distance * stream.direction > 0 && labs(distance) <= WINDOW);
+            if (extends) {
+                stream.direction = (distance > 0) ? 1 : -1;
+                stream.head      = block;
+                stream.lru       = clock_;
+                for (ulong i = 1; i <= degree_; i++) {
+                    candidates.push_back((block + i * stream.direction) * block_size_);
+                }
+                return;
+            }
+
+            if (victim->valid && stream.lru < victim->lru) {
+                victim = &stream;
+            }
+        }
+
+        /* Start tracking a new stream */
+        *victim = stream_t();
+        victim->head  = block;
+        victim->lru   = clock_;
+        victim->valid = true;
+    }
+};
+
+/**
+ * @brief Create a prefetcher in the arena
+ * 
+ * @return Prefetcher* NULL for prefetcher_e::None
+ */
+Prefetcher *Prefetcher::create(prefetcher_e type, ulong block_size, ulong degree, Arena &arena) {
+    switch (type) {
+        case prefetcher_e::None     : return NULL;
+        case prefetcher_e::NextLine : return arena.create<PrefetcherNextLine>(block_size, degree);
+        case prefetcher_e::Stride   : return arena.create<PrefetcherStride>(block_size, degree);
+        case prefetcher_e::Stream   : return arena.create<PrefetcherStream>(block_size, degree);
+    }
+    FATAL(": Unknown prefetcher " << type);
+}
@@ -0,0 +1,40 @@
+#ifndef __PREFETCHER_H__
+#define __PREFETCHER_H__
+
+#include <vector>
+#include "types.h"
+#include "arena.h"
+
+/**
+ * @brief Abstract class. A prefetcher watches the demand accesses of one cache
+ * and suggests blocks to fetch ahead of time. The cache issues the prefetches
+ * as regular coherence transactions.
+ * 
+ * Prefetchers are placed in the simulation's arena, so they keep their tables inline.
+ */
+class Prefetcher {
+
+protected:
+    ulong block_size_;
+    ulong degree_;      /* Number of blocks suggested per trigger */
+
+public:
+    Prefetcher(ulong block_size, ulong degree)
+    : block_size_ {block_size}
+    , degree_     {degree}
+    {}
+    virtual ~Prefetcher() = default;
+
+    /**
+     * @brief Observe a demand access.
+     * 
+     * @param addr 
+     * @param miss Whether the access missed, or hit a block that was prefetched
+     * @param candidates Addresses of the blocks to prefetch are appended to it
+     */
+    virtual void observe(ulong addr, bool miss, std::vector<ulong> &candidates) = 0;
+
+    static Prefetcher *create(prefetcher_e type, ulong block_size, ulong degree, Arena &arena);
+};
+
+#endif /* __PREFETCHER_H__ */
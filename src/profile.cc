@@ -0,0 +1,72 @@
+#include <stdio.h>
+#include <iostream>
+#include "profile.h"
+
+static const char *phase_names[] = {
+    "parse", "lookup", "fill", "request", "transition", "snoop", "bookkeeping", "stats"
+};
+
+Profiler::Profiler(ulong num_cores, ulong period)
+: period_ {period}
+, num_fan_outs_ (num_cores, 0)
+, num_snoops_sent_ (num_cores, 0)
+, num_queries_ (num_cores, 0)
+, num_snoops_ (num_cores, 0)
+, start_cycles_ {read_cycles()}
+, start_time_ {std::chrono::steady_clock::now()}
+{
+    if (period_ == 0) {
+        FATAL(": The profile period must be at least 1");
+    }
+
+    /* Calibrate the cost of a lap on laps that time nothing */
+    const ulong num_laps = 4096;
+    sampled_ = true;
+    ulong start = read_cycles();
+    ulong lap_start = start;
+    for (ulong i = 0; i < num_laps; i++) {
+        lap_start = lap(phase_e::Stats, lap_start);
+    }
+    overhead_ = (read_cycles() - start) / num_laps;
+    phases_[static_cast<int>(phase_e::Stats)] = phase_stats_t();
+    sampled_ = false;
+}
+
+/**
+ * @brief Print the estimated time of every phase, and the snoop fan-out of every core.
+ * The cycle counter is converted to time with the rate it ran at during the run.
+ * Shares are of the time attributed to the phases: timed accesses still run a little
+ * slower than the others, so the estimates can add up to more than the run took.
+ */
+void Profiler::print() const {
+
+    ulong elapsed  = read_cycles() - start_cycles_;
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time_).count();
+    double rate    = seconds > 0 ? elapsed / seconds : 0.0;
+
+    printf("============ Profile (1 in %lu accesses timed, %.2lf Gcycles/s) ============\n", period_, rate / 1e9);
+    printf("%-14s %14s %14s %14s %10s %8s\n", "phase", "calls", "timed calls", "cycles/call", "est. ms", "share");
+
+    double total = 0.0;
+    for (const phase_stats_t &p : phases_) {
+        total += p.timed_calls ? (double) p.cycles * p.calls / p.timed_calls : 0.0;
+    }
+
+    for (int i = 0; i < static_cast<int>(phase_e::NumPhases); i++) {
+        const phase_stats_t &p = phases_[i];
+        double per_call  = p.timed_calls ? (double) p.cycles / p.timed_calls : 0.0;
+        double estimated = per_call * p.calls;
+        printf("%-14s %14lu %14lu %14.1lf %10.2lf %7.2lf%%\n", phase_names[i], p.calls, p.timed_calls, per_call,
+               rate > 0 ? estimated * 1e3 / rate : 0.0, total > 0 ? estimated * 100 / total : 0.0);
+    }
+    printf("%-14s %14s %14s %14s %10.2lf\n", "unattributed", "", "", "",
+           rate > 0 && elapsed > total ? (elapsed - total) * 1e3 / rate : 0.0);
+    printf("%-14s %14s %14s %14s %10.2lf\n", "total", "", "", "", seconds * 1e3);
+
+    printf("============ Snoop fan-out ============\n");
+    printf("%-10s %14s %14s %14s %12s\n", "core", "fanned out", "queries recv", "snoops recv", "avg fan-out");
+    for (ulong core = 0; core < num_snoops_.size(); core++) {
+        double fan_out = num_fan_outs_[core] ? (double) num_snoops_sent_[core] / num_fan_outs_[core] : 0.0;
+        printf("core %-5lu %14lu %14lu %14lu %12.2lf\n", core, num_fan_outs_[core], num_queries_[core], num_snoops_[core], fan_out);
+    }
+}
@@ -0,0 +1,128 @@
+#ifndef __PROFILE_H__
+#define __PROFILE_H__
+
+#include <chrono>
+#include <vector>
+#include "types.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <time.h>
+#endif
+
+/* One access in PROFILE_PERIOD is timed by default */
+#define PROFILE_PERIOD 64
+
+/**
+ * Phases of the simulator's own work, timed by --profile.
+ * The phases of an access follow each other, they never nest.
+ */
+enum class phase_e : uint8_t {
+    Parse,          /* Reading and parsing the trace */
+    Lookup,         /* Tag match in the sets and the victim cache */
+    Fill,           /* Picking and evicting a victim on a miss, writebacks included */
+    Request,        /* Asking the other caches whether they have a copy (Bus::respond) */
+    Transition,     /* State machine of the requesting cache */
+    Snoop,          /* Posting the transaction, with the snoops of the receiving caches (Bus::receive) */
+    Bookkeeping,    /* Prefetcher and outcome stream */
+    Stats,          /* Snapshot and printing of the counters */
+    NumPhases
+};
+
+/* Cycle counter of the host. It only needs to be cheap and monotonic */
+static inline ulong read_cycles() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000UL + ts.tv_nsec;
+#endif
+}
+
+/**
+ * @brief Where the simulator spends its time.
+ *
+ * Every phase of every access is counted, but only one access in `period`
+ * reads the cycle counter, so that the profile does not distort the run it
+ * measures. The time of a phase is extrapolated from its timed calls.
+ * Phases outside of the accesses (parsing, statistics) are always timed.
+ *
+ * The buses also count how many caches every snoop fans out to.
+ */
+class Profiler {
+private:
+    struct phase_stats_t {
+        ulong calls{0}, timed_calls{0}, cycles{0};
+    };
+
+    phase_stats_t phases_[static_cast<int>(phase_e::NumPhases)];
+    ulong period_;
+    ulong countdown_{1};
+    bool  sampled_{false};
+
+    /* Cycles it takes to read the counter, taken out of every lap */
+    ulong overhead_{0};
+
+    /* Per core: transactions it fanned out and the snoops they delivered, copy queries and snoops it received */
+    std::vector<ulong> num_fan_outs_, num_snoops_sent_, num_queries_, num_snoops_;
+
+    ulong start_cycles_;
+    std::chrono::steady_clock::time_point start_time_;
+
+public:
+    Profiler(ulong num_cores, ulong period = PROFILE_PERIOD);
+
+    /**
+     * @brief Decide whether the access that starts now is timed
+     *
+     * @return the start of its first phase
+     */
+    ulong begin_access() {
+        sampled_ = (--countdown_ == 0);
+        if (!sampled_) {
+            return 0;
+        }
+        countdown_ = period_;
+        return read_cycles();
+    }
+
+    /**
+     * @brief End a phase of the current access
+     *
+     * @param start the start of the phase
+     * @return the start of the next phase
+     */
+    ulong lap(phase_e phase, ulong start) {
+        phase_stats_t &p = phases_[static_cast<int>(phase)];
+        p.calls++;
+        if (!sampled_) {
+            return 0;
+        }
+        ulong now = read_cycles();
+        p.timed_calls++;
+        p.cycles += (now - start > overhead_) ? now - start - overhead_ : 0;
+        return now;
+    }
+
+    /* Account for a phase that was timed as a whole */
+    void add(phase_e phase, ulong cycles, ulong calls = 1) {
+        phase_stats_t &p = phases_[static_cast<int>(phase)];
+        p.calls       += calls;
+        p.timed_calls += calls;
+        p.cycles      += cycles;
+    }
+
+    void count_fan_out(ulong core)  { num_fan_outs_[core]++; }
+    void count_query(ulong core)    { num_queries_[core]++; }
+
+    void count_snoop(ulong requester, ulong receiver) {
+        num_snoops_sent_[requester]++;
+        num_snoops_[receiver]++;
+    }
+
+    void print() const;
+};
+
+#endif /* __PROFILE_H__ */
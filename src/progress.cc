@@ -0,0 +1,162 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <iostream>
+#include "progress.h"
+#include "system.h"
+
+static ulong monotonic_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000UL + ts.tv_nsec;
+}
+
+/**
+ * @brief Create (or truncate) the file at `path` and map it as the progress page
+ *
+ * @param path          usually a file under /dev/shm
+ * @param num_cores
+ * @param trace_bytes   size of the trace, for the estimate of the remaining time
+ */
+ProgressPage::ProgressPage(const std::string &path, ulong num_cores, ulong trace_bytes)
+: size_ {progress_page_t::size(num_cores)}
+{
+    int fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0 || ftruncate(fd, size_) != 0) {
+        FATAL(": Unable to create progress page " << path);
+    }
+
+    void *addr = mmap(NULL, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) {
+        FATAL(": Unable to map progress page " << path);
+    }
+
+    page_ = new (addr) progress_page_t();
+    for (ulong i = 0; i < num_cores; i++) {
+        new (&page_->cores()[i]) progress_core_t();
+    }
+
+    page_->num_cores = num_cores;
+    page_->version   = PROGRESS_VERSION;
+    page_->trace_bytes.store(trace_bytes, std::memory_order_relaxed);
+    page_->start_ns.store(monotonic_ns(), std::memory_order_relaxed);
+    page_->update_ns.store(page_->start_ns.load(std::memory_order_relaxed), std::memory_order_relaxed);
+
+    /* Readers only trust the page once the magic number is there */
+    std::atomic_thread_fence(std::memory_order_release);
+    page_->magic = PROGRESS_MAGIC;
+}
+
+ProgressPage::~ProgressPage() {
+    munmap(page_, size_);
+}
+
+/**
+ * @brief Publish the current counters of `system`.
+ * This takes a snapshot of every cache, so it is meant to be called once per batch of references.
+ *
+ * @param num_warmup_refs references replayed so far to warm the caches up, which the counters do not include
+ */
+void ProgressPage::update(const System &system, ulong trace_bytes_read, ulong num_warmup_refs, bool done) {
+    ulong seq = page_->seq.load(std::memory_order_relaxed);
+
+    page_->seq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    page_->done.store(done, std::memory_order_relaxed);
+    page_->num_refs.store(system.get_num_accesses(), std::memory_order_relaxed);
+    page_->num_warmup_refs.store(num_warmup_refs, std::memory_order_relaxed);
+    page_->trace_bytes_read.store(trace_bytes_read, std::memory_order_relaxed);
+    page_->update_ns.store(monotonic_ns(), std::memory_order_relaxed);
+
+    for (ulong i = 0; i < page_->num_cores; i++) {
+        cache_stats_t stats = system.get_stats(i);
+        progress_core_t &core = page_->cores()[i];
+
+        core.num_reads.store(stats.num_reads, std::memory_order_relaxed);
+        core.num_read_misses.store(stats.num_read_misses, std::memory_order_relaxed);
+        core.num_writes.store(stats.num_writes, std::memory_order_relaxed);
+        core.num_write_misses.store(stats.num_write_misses, std::memory_order_relaxed);
+        core.num_write_backs.store(stats.num_write_backs, std::memory_order_relaxed);
+        core.num_invalidations.store(stats.coherence.num_invalidations, std::memory_order_relaxed);
+        core.num_interventions.store(stats.coherence.num_interventions, std::memory_order_relaxed);
+        core.num_flushes.store(stats.coherence.num_flushes, std::memory_order_relaxed);
+        core.num_busrdx.store(stats.coherence.num_busrdx, std::memory_order_relaxed);
+        core.num_busupd.store(stats.coherence.num_busupd, std::memory_order_relaxed);
+    }
+
+    page_->seq.store(seq + 2, std::memory_order_release);
+}
+
+const progress_page_t *open_progress(const std::string &path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return NULL;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t) st.st_size < sizeof(progress_page_t)) {
+        close(fd);
+        return NULL;
+    }
+
+    void *addr = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) {
+        return NULL;
+    }
+
+    const progress_page_t *page = static_cast<const progress_page_t*>(addr);
+    if (page->magic != PROGRESS_MAGIC || page->version != PROGRESS_VERSION ||
+        progress_page_t::size(page->num_cores) > (size_t) st.st_size) {
+        munmap(addr, st.st_size);
+        return NULL;
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return page;
+}
+
+void read_progress(const progress_page_t *page, progress_snapshot_t &snapshot) {
+    snapshot.caches.resize(page->num_cores);
+
+    while (true) {
+        ulong seq = page->seq.load(std::memory_order_acquire);
+        if (seq & 1) {
+            continue;
+        }
+
+        snapshot.done              = page->done.load(std::memory_order_relaxed);
+        snapshot.num_refs          = page->num_refs.load(std::memory_order_relaxed);
+        snapshot.num_warmup_refs   = page->num_warmup_refs.load(std::memory_order_relaxed);
+        snapshot.trace_bytes       = page->trace_bytes.load(std::memory_order_relaxed);
+        snapshot.trace_bytes_read  = page->trace_bytes_read.load(std::memory_order_relaxed);
+        snapshot.start_ns          = page->start_ns.load(std::memory_order_relaxed);
+        snapshot.update_ns         = page->update_ns.load(std::memory_order_relaxed);
+
+        for (ulong i = 0; i < page->num_cores; i++) {
+            const progress_core_t &core = page->cores()[i];
+            cache_stats_t &stats = snapshot.caches[i];
+
+            stats.num_reads                      = core.num_reads.load(std::memory_order_relaxed);
+            stats.num_read_misses                = core.num_read_misses.load(std::memory_order_relaxed);
+            stats.num_writes                     = core.num_writes.load(std::memory_order_relaxed);
+            stats.num_write_misses               = core.num_write_misses.load(std::memory_order_relaxed);
+            stats.num_write_backs                = core.num_write_backs.load(std::memory_order_relaxed);
+            stats.coherence.num_invalidations    = core.num_invalidations.load(std::memory_order_relaxed);
+            stats.coherence.num_interventions    = core.num_interventions.load(std::memory_order_relaxed);
+            stats.coherence.num_flushes          = core.num_flushes.load(std::memory_order_relaxed);
+            stats.coherence.num_busrdx           = core.num_busrdx.load(std::memory_order_relaxed);
+            stats.coherence.num_busupd           = core.num_busupd.load(std::memory_order_relaxed);
+        }
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (page->seq.load(std::memory_order_relaxed) == seq) {
+            return;
+        }
+    }
+}
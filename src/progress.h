@@ -0,0 +1,97 @@
+#ifndef __PROGRESS_H__
+#define __PROGRESS_H__
+
+#include <atomic>
+#include <string>
+#include <vector>
+#include "types.h"
+#include "cache.h"
+
+class System;
+
+#define PROGRESS_MAGIC     0x43504d53UL    /* "SMPC" */
+#define PROGRESS_VERSION   2
+
+static_assert(ATOMIC_LONG_LOCK_FREE == 2, "The progress page needs lock-free counters");
+
+/**
+ * @brief Counters of one cache, as published in the progress page
+ */
+struct progress_core_t {
+    std::atomic<ulong> num_reads, num_read_misses, num_writes, num_write_misses, num_write_backs;
+    std::atomic<ulong> num_invalidations, num_interventions, num_flushes, num_busrdx, num_busupd;
+};
+
+/**
+ * @brief Layout of the shared progress page. The header is followed by one
+ * progress_core_t per core.
+ *
+ * The page is a seqlock: the simulator makes `seq` odd while it updates the
+ * counters and even again when it is done. Readers never block the simulator,
+ * they retry if `seq` was odd or changed while they copied the counters.
+ */
+struct progress_page_t {
+    uint32_t magic;
+    uint32_t version;
+    ulong    num_cores;
+
+    std::atomic<ulong> seq;
+    std::atomic<ulong> done;                /* Set once the whole trace has been replayed */
+    std::atomic<ulong> num_refs;            /* References processed so far */
+    std::atomic<ulong> num_warmup_refs;     /* Of which warmed the caches up, the counters leave them out */
+    std::atomic<ulong> trace_bytes;         /* Size of the trace, to estimate the remaining time */
+    std::atomic<ulong> trace_bytes_read;
+    std::atomic<ulong> start_ns, update_ns; /* CLOCK_MONOTONIC */
+
+    progress_core_t *cores() { return reinterpret_cast<progress_core_t*>(this + 1); }
+    const progress_core_t *cores() const { return reinterpret_cast<const progress_core_t*>(this + 1); }
+
+    static size_t size(ulong num_cores) { return sizeof(progress_page_t) + num_cores * sizeof(progress_core_t); }
+};
+
+/**
+ * @brief A consistent copy of the progress page
+ */
+struct progress_snapshot_t {
+    bool  done{false};
+    ulong num_refs{0}, num_warmup_refs{0};
+    ulong trace_bytes{0}, trace_bytes_read{0};
+    ulong start_ns{0}, update_ns{0};
+    std::vector<cache_stats_t> caches;
+
+    double elapsed() const          { return (update_ns - start_ns) * 1e-9; }
+    double refs_per_second() const  { return elapsed() > 0 ? num_refs / elapsed() : 0.0; }
+
+    /* Estimated seconds left, from the share of the trace already read */
+    double eta() const {
+        return trace_bytes_read ? elapsed() * (trace_bytes - trace_bytes_read) / trace_bytes_read : 0.0;
+    }
+};
+
+/**
+ * @brief Publishes the progress of a run in a file mapped into memory,
+ * typically under /dev/shm. The simulator calls update() between batches
+ * of references, never from the Access() path.
+ */
+class ProgressPage {
+private:
+    progress_page_t *page_{nullptr};
+    size_t size_{0};
+
+public:
+    ProgressPage(const std::string &path, ulong num_cores, ulong trace_bytes);
+    ~ProgressPage();
+
+    ProgressPage(const ProgressPage &) = delete;
+    ProgressPage &operator=(const ProgressPage &) = delete;
+
+    void update(const System &system, ulong trace_bytes_read, ulong num_warmup_refs = 0, bool done = false);
+};
+
+/* Map a progress page for reading. Returns NULL if `path` is not a progress page */
+const progress_page_t *open_progress(const std::string &path);
+
+/* Copy a consistent snapshot of the page without ever blocking the writer */
+void read_progress(const progress_page_t *page, progress_snapshot_t &snapshot);
+
+#endif /* __PROGRESS_H__ */
@@ -0,0 +1,319 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include <iostream>
+#include <fstream>
+#include <unordered_map>
+#include "result_cache.h"
+
+#define FNV_OFFSET_BASIS  0xcbf29ce484222325UL
+#define FNV_PRIME         0x100000001b3UL
+
+static ulong fnv1a(const void *data, size_t size, ulong hash = FNV_OFFSET_BASIS) {
+    const uchar *bytes = static_cast<const uchar*>(data);
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+/**
+ * @brief Call `f(prefix, name, value)` on every counter of a snapshot.
+ * Storing and loading walk the counters through this single list,
+ * so that the two can never disagree on the format.
+ */
+template <typename F>
+static void visit(system_stats_t &stats, F &f) {
+    char prefix[64];
+
+    for (ulong i = 0; i < stats.caches.size(); i++) {
+        cache_stats_t &c = stats.caches[i];
+        snprintf(prefix, sizeof(prefix), "core.%lu.", i);
+
+        f(prefix, "num_reads",                       c.num_reads);
+        f(prefix, "num_read_misses",                 c.num_read_misses);
+        f(prefix, "num_writes",                      c.num_writes);
+        f(prefix, "num_write_misses",                c.num_write_misses);
+        f(prefix, "num_write_backs",                 c.num_write_backs);
+        f(prefix, "num_invalidations",               c.coherence.num_invalidations);
+        f(prefix, "num_interventions",               c.coherence.num_interventions);
+        f(prefix, "num_busrdx",                      c.coherence.num_busrdx);
+        f(prefix, "num_busupd",                      c.coherence.num_busupd);
+        f(prefix, "num_flushes",                     c.coherence.num_flushes);
+        f(prefix, "num_prefetches",                  c.num_prefetches);
+        f(prefix, "num_useful_prefetches",           c.num_useful_prefetches);
+        f(prefix, "num_useless_prefetches",          c.num_useless_prefetches);
+        f(prefix, "prefetch_lead",                   c.prefetch_lead);
+        f(prefix, "num_prefetch_bus_transactions",   c.num_prefetch_bus_transactions);
+        f(prefix, "num_prefetch_invalidations",      c.num_prefetch_invalidations);
+        f(prefix, "num_prefetch_interventions",      c.num_prefetch_interventions);
+        f(prefix, "num_prefetch_flushes",            c.num_prefetch_flushes);
+        f(prefix, "num_victim_hits",                 c.num_victim_hits);
+        f(prefix, "num_wb_coalesced",                c.num_wb_coalesced);
+        f(prefix, "num_wb_snoop_flushes",            c.num_wb_snoop_flushes);
+        f(prefix, "num_wb_retired",                  c.num_wb_retired);
+        f(prefix, "num_wb_pending",                  c.num_wb_pending);
+        f(prefix, "num_atomics",                     c.num_atomics);
+        f(prefix, "num_atomic_misses",               c.num_atomic_misses);
+        f(prefix, "num_atomic_bus_transactions",     c.num_atomic_bus_transactions);
+        f(prefix, "num_atomic_invalidations",        c.num_atomic_invalidations);
+        f(prefix, "num_atomic_flushes",              c.num_atomic_flushes);
+        f(prefix, "num_fences",                      c.num_fences);
+        f(prefix, "num_fence_write_backs",           c.num_fence_write_backs);
+    }
+
+    for (ulong bank = 0; bank < stats.banks.size(); bank++) {
+        bus_stats_t &b = stats.banks[bank];
+        bus_traffic_t *traffic[] = { &b.busrd, &b.busrdx, &b.busupd, &b.flush, &b.writeback };
+        const char *names[]      = { "busrd", "busrdx", "busupd", "flush", "writeback" };
+
+        for (ulong t = 0; t < 5; t++) {
+            snprintf(prefix, sizeof(prefix), "bank.%lu.%s.", bank, names[t]);
+            f(prefix, "count",          traffic[t]->count);
+            f(prefix, "command_bytes",  traffic[t]->command_bytes);
+            f(prefix, "data_bytes",     traffic[t]->data_bytes);
+        }
+        for (ulong core = 0; core < b.core_bytes.size(); core++) {
+            snprintf(prefix, sizeof(prefix), "bank.%lu.core.%lu.", bank, core);
+            f(prefix, "bytes", b.core_bytes[core]);
+        }
+
+        /* The number of intervals comes first, so that loading knows how many to read */
+        snprintf(prefix, sizeof(prefix), "bank.%lu.", bank);
+        ulong num_intervals = b.interval_bytes.size();
+        f(prefix, "num_intervals", num_intervals);
+        b.interval_bytes.resize(num_intervals, 0);
+        for (ulong interval = 0; interval < num_intervals; interval++) {
+            snprintf(prefix, sizeof(prefix), "bank.%lu.interval.%lu.", bank, interval);
+            f(prefix, "bytes", b.interval_bytes[interval]);
+        }
+    }
+
+    numa_stats_t &n = stats.numa;
+    f("numa.", "num_local_interventions",     n.num_local_interventions);
+    f("numa.", "num_remote_interventions",    n.num_remote_interventions);
+    f("numa.", "num_local_flushes",           n.num_local_flushes);
+    f("numa.", "num_remote_flushes",          n.num_remote_flushes);
+    f("numa.", "num_local_memory",            n.num_local_memory);
+    f("numa.", "num_remote_memory",           n.num_remote_memory);
+    f("numa.", "num_transactions",            n.num_transactions);
+    f("numa.", "num_remote_snoops",           n.num_remote_snoops);
+    f("numa.", "num_filtered_snoops",         n.num_filtered_snoops);
+    f("numa.", "num_hops",                    n.num_hops);
+
+    dram_stats_t &d = stats.dram;
+    f("dram.", "num_reads",                   d.num_reads);
+    f("dram.", "num_writes",                  d.num_writes);
+    f("dram.", "num_row_hits",                d.num_row_hits);
+    f("dram.", "num_row_misses",              d.num_row_misses);
+    f("dram.", "num_row_conflicts",           d.num_row_conflicts);
+    f("dram.", "read_latency",                d.read_latency);
+    f("dram.", "num_bytes",                   d.num_bytes);
+    f("dram.", "num_cycles",                  d.num_cycles);
+    f("dram.", "max_queue",                   d.max_queue);
+
+    for (ulong i = 0; i < stats.cores.size(); i++) {
+        core_stats_t &c = stats.cores[i];
+        snprintf(prefix, sizeof(prefix), "timing.%lu.", i);
+
+        f(prefix, "num_instructions",           c.num_instructions);
+        f(prefix, "num_cycles",                 c.num_cycles);
+        f(prefix, "num_upgrades",               c.num_upgrades);
+        f(prefix, "num_remote_fills",           c.num_remote_fills);
+        f(prefix, "num_memory_fills",           c.num_memory_fills);
+        f(prefix, "num_mshr_stalls",            c.num_mshr_stalls);
+        f(prefix, "mshr_stall_cycles",          c.mshr_stall_cycles);
+        f(prefix, "num_drains",                 c.num_drains);
+        f(prefix, "drain_stall_cycles",         c.drain_stall_cycles);
+        f(prefix, "miss_cycles",                c.miss_cycles);
+    }
+}
+
+struct stats_writer_t {
+    FILE *out;
+
+    void operator()(const char *prefix, const char *name, ulong &value) {
+        fprintf(out, "%s%s=%lu\n", prefix, name, value);
+    }
+};
+
+struct stats_reader_t {
+    std::unordered_map<std::string, ulong> values;
+    bool complete{true};
+
+    void operator()(const char *prefix, const char *name, ulong &value) {
+        auto it = values.find(std::string(prefix) + name);
+        if (it == values.end()) {
+            complete = false;
+            return;
+        }
+        value = it->second;
+    }
+};
+
+
+ResultCache::ResultCache(const std::string &dir)
+: dir_ {dir}
+{
+}
+
+ulong ResultCache::hash_trace(const char *fname) {
+    FILE *trace = fopen(fname, "rb");
+    if (!trace) {
+        FATAL(": Unable to open trace file " << fname);
+    }
+
+    static char buffer[1 << 16];
+    ulong hash = FNV_OFFSET_BASIS;
+    size_t size;
+    while ((size = fread(buffer, 1, sizeof(buffer), trace)) > 0) {
+        hash = fnv1a(buffer, size, hash);
+    }
+    fclose(trace);
+    return hash;
+}
+
+/**
+ * @brief Everything a run depends on, one key=value per line.
+ * It is hashed into the name of the result file and repeated at the top of it.
+ */
+std::string ResultCache::describe(ulong trace_hash, const system_config_t &config, const trace_window_t &window) {
+    std::stringstream ss;
+    ss << "version="           << SMP_CACHE_VERSION         << '\n'
+       << "trace="             << std::hex << trace_hash << std::dec << '\n'
+       << "cache_size="        << config.cache_size         << '\n'
+       << "assoc="             << config.assoc              << '\n'
+       << "block_size="        << config.block_size         << '\n'
+       << "num_processors="    << config.num_processors     << '\n'
+       << "protocol="          << config.protocol           << '\n'
+       << "storage="           << config.storage            << '\n'
+       << "set_index="         << config.set_index          << '\n'
+       << "addr_bytes="        << config.addr_bytes         << '\n'
+       << "word_bytes="        << config.word_bytes         << '\n'
+       << "num_banks="         << config.num_banks          << '\n'
+       << "num_sockets="       << config.num_sockets        << '\n'
+       << "numa="              << config.numa               << '\n'
+       << "socket_map=";
+    for (ulong socket : config.socket_map) {
+        ss << socket << ',';
+    }
+    ss << '\n'
+       << "prefetcher="        << config.prefetcher         << '\n'
+       << "prefetch_degree="   << config.prefetch_degree    << '\n'
+       << "victim_entries="    << config.victim_entries     << '\n'
+       << "wb_buffer_entries=" << config.wb_buffer_entries  << '\n'
+       << "dram_channels="     << config.dram_channels      << '\n'
+       << "dram_banks="        << config.dram_banks         << '\n'
+       << "dram_policy="       << config.dram_policy        << '\n'
+       << "dram_mode="         << config.dram_mode          << '\n'
+       << "dram_cycles_per_ref=" << config.dram_cycles_per_ref << '\n'
+       << "quantum="           << config.quantum            << '\n'
+       << "ipc="               << config.ipc                << '\n'
+       << "mshrs="             << config.mshrs              << '\n'
+       << "upgrade_latency="   << config.upgrade_latency    << '\n'
+       << "remote_latency="    << config.remote_latency     << '\n'
+       << "memory_latency="    << config.memory_latency     << '\n'
+       << "bus_interval="      << config.bus_interval       << '\n'
+       << "skip="              << window.skip               << '\n'
+       << "limit="             << window.limit              << '\n'
+       << "warmup="            << window.warmup             << '\n'
+       << "roi="               << window.roi                << '\n'
+       << "cores=";
+    for (ulong core : window.cores) {
+        ss << core << ',';
+    }
+    ss << '\n';
+    return ss.str();
+}
+
+std::string ResultCache::key(ulong trace_hash, const system_config_t &config, const trace_window_t &window) const {
+    std::string description = describe(trace_hash, config, window);
+    char key[17];
+    snprintf(key, sizeof(key), "%016lx", fnv1a(description.data(), description.size()));
+    return key;
+}
+
+std::string ResultCache::path(const std::string &key) const {
+    return dir_ + "/" + key + ".stats";
+}
+
+bool ResultCache::load(ulong trace_hash, const system_config_t &config, const trace_window_t &window, system_stats_t &stats) const {
+    std::ifstream in(path(key(trace_hash, config, window)));
+    if (!in) {
+        return false;
+    }
+
+    /* The header must match exactly, anything else is a collision or a stale file */
+    std::string header = describe(trace_hash, config, window);
+    std::string line;
+    std::string file_header;
+    stats_reader_t reader;
+
+    while (std::getline(in, line)) {
+        if (file_header.size() < header.size()) {
+            file_header += line + '\n';
+            continue;
+        }
+        size_t equals = line.find('=');
+        if (equals == std::string::npos) {
+            return false;
+        }
+        reader.values[line.substr(0, equals)] = strtoul(line.c_str() + equals + 1, NULL, 10);
+    }
+    if (file_header != header) {
+        return false;
+    }
+
+    system_stats_t loaded;
+    loaded.caches.resize(config.num_processors);
+    loaded.banks.resize(config.num_banks);
+    for (bus_stats_t &bank : loaded.banks) {
+        bank.core_bytes.resize(config.num_processors, 0);
+    }
+    if (config.ipc > 0.0) {
+        loaded.cores.resize(config.num_processors);
+    }
+    visit(loaded, reader);
+    if (!reader.complete) {
+        return false;
+    }
+
+    stats = loaded;
+    return true;
+}
+
+/**
+ * @brief Store the results of a run. The file is written under a temporary name
+ * and renamed into place, so that concurrent sweeps never read a partial file.
+ * Failures only cost the next run a simulation, so they are not fatal.
+ */
+void ResultCache::store(ulong trace_hash, const system_config_t &config, const trace_window_t &window, const system_stats_t &stats) const {
+    if (mkdir(dir_.c_str(), 0777) != 0 && errno != EEXIST) {
+        fprintf(stderr, "WARNING: Unable to create result cache %s\n", dir_.c_str());
+        return;
+    }
+
+    std::string final_path = path(key(trace_hash, config, window));
+    std::string temp_path  = final_path + ".tmp." + std::to_string(getpid());
+
+    FILE *out = fopen(temp_path.c_str(), "w");
+    if (!out) {
+        fprintf(stderr, "WARNING: Unable to write to result cache %s\n", dir_.c_str());
+        return;
+    }
+
+    std::string header = describe(trace_hash, config, window);
+    fputs(header.c_str(), out);
+
+    system_stats_t copy = stats;
+    stats_writer_t writer{out};
+    visit(copy, writer);
+
+    if (fclose(out) != 0 || rename(temp_path.c_str(), final_path.c_str()) != 0) {
+        fprintf(stderr, "WARNING: Unable to write to result cache %s\n", dir_.c_str());
+        unlink(temp_path.c_str());
+    }
+}
@@ -0,0 +1,44 @@
+#ifndef __RESULT_CACHE_H__
+#define __RESULT_CACHE_H__
+
+#include <string>
+#include "types.h"
+#include "system.h"
+#include "trace.h"
+
+/**
+ * Version of the simulation model: results stored by another version are never served.
+ * The Makefile derives it from a checksum of the sources, so that any change to the
+ * simulator invalidates the results of the builds before it.
+ */
+#ifndef SMP_CACHE_VERSION
+#define SMP_CACHE_VERSION "unversioned"
+#endif
+
+/**
+ * @brief An on-disk store of the results of previous runs.
+ * A run is identified by a hash of the contents of its trace, the part of
+ * the trace it replays, its full configuration and the simulator version.
+ * Each run is stored as a small key=value file named after that hash, which
+ * repeats all of the above so that a hash collision is never served.
+ */
+class ResultCache {
+private:
+    std::string dir_;
+
+    static std::string describe(ulong trace_hash, const system_config_t &config, const trace_window_t &window);
+    std::string key(ulong trace_hash, const system_config_t &config, const trace_window_t &window) const;
+    std::string path(const std::string &key) const;
+
+public:
+    explicit ResultCache(const std::string &dir);
+
+    /* FNV-1a hash of the contents of a trace file */
+    static ulong hash_trace(const char *fname);
+
+    /* Return true and fill `stats` if the run was stored before */
+    bool load(ulong trace_hash, const system_config_t &config, const trace_window_t &window, system_stats_t &stats) const;
+    void store(ulong trace_hash, const system_config_t &config, const trace_window_t &window, const system_stats_t &stats) const;
+};
+
+#endif /* __RESULT_CACHE_H__ */
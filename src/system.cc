@@ -0,0 +1,362 @@
+#include <iostream>
+#include <algorithm>
+#include "system.h"
+
+System::System(const system_config_t &config)
+: config_ {config}
+{
+   build();
+}
+
+System::~System() {
+   destroy();
+   delete workers_;
+}
+
+/**
+ * @brief Create the interconnect and the caches for the current configuration in the arena
+ */
+void System::build() {
+   if (config_.num_processors == 0) {
+      FATAL(": A system needs at least one processor");
+   }
+
+   bus_config_t bus_config;
+   bus_config.addr_bytes   = config_.addr_bytes;
+   bus_config.word_bytes   = config_.word_bytes;
+   bus_config.block_bytes  = config_.block_size;
+   bus_config.interval     = get_bus_interval(config_);
+
+   interconnect_config_t interconnect_config;
+   interconnect_config.num_cores   = config_.num_processors;
+   interconnect_config.num_banks   = config_.num_banks;
+   interconnect_config.num_sockets = config_.num_sockets;
+   interconnect_config.numa        = config_.numa;
+   interconnect_config.socket_map  = config_.socket_map;
+
+   interconnect_ = arena_.create<Interconnect>(interconnect_config, bus_config, arena_);
+
+   if (config_.dram_channels > 0) {
+      dram_ = arena_.create<Dram>(get_dram_config(config_));
+      interconnect_->set_memory(dram_);
+   }
+   interconnect_->set_profiler(profiler_);
+   caches_.resize(config_.num_processors);
+   blocked_.assign(config_.num_processors, 0);
+
+   for(uint i = 0; i < config_.num_processors; i++) {
+      caches_[i] = arena_.create<Cache>(i, config_.cache_size, config_.assoc, config_.block_size, config_.protocol, arena_, config_.storage, config_.set_index);
+      caches_[i]->set_prefetcher(Prefetcher::create(config_.prefetcher, config_.block_size, config_.prefetch_degree, arena_));
+      caches_[i]->set_victim_cache(config_.victim_entries);
+      caches_[i]->set_write_back_buffer(config_.wb_buffer_entries);
+      caches_[i]->set_outcome_stream(outcomes_);
+      caches_[i]->set_profiler(profiler_);
+      /* Without cores, the time of a cache is the one the timed DRAM gives its references */
+      if (config_.ipc == 0.0 && config_.dram_mode == dram_mode_e::Timed) {
+         caches_[i]->set_cycles_per_ref(config_.dram_cycles_per_ref);
+      }
+      /* Two way communication between the cache and the interconnect */
+      caches_[i]->connect(interconnect_);
+      interconnect_->attach(caches_[i], i);
+   }
+
+   if (config_.ipc > 0.0) {
+      core_config_t core_config = get_core_config(config_);
+      for (Cache *cache : caches_) {
+         cores_.push_back(arena_.create<Core>(core_config, cache));
+      }
+   }
+}
+
+/**
+ * @brief Run the destructors of the objects in the arena.
+ * Their memory is reclaimed when the arena is reset.
+ */
+void System::destroy() {
+   for (Core *core : cores_) {
+      core->~Core();
+   }
+   cores_.clear();
+
+   for (Cache *cache : caches_) {
+      cache->~Cache();
+   }
+   caches_.clear();
+
+   if (interconnect_ != nullptr) {
+      interconnect_->~Interconnect();
+      interconnect_ = nullptr;
+   }
+
+   if (dram_ != nullptr) {
+      dram_->~Dram();
+      dram_ = nullptr;
+   }
+}
+
+/**
+ * @brief Replay a batch of references. The references are applied in order,
+ * exactly as if they had been read one by one from a trace file.
+ * 
+ * @param refs 
+ * @param num_refs 
+ */
+void System::access(const access_t *refs, size_t num_refs) {
+   if (config_.quantum != 0) {
+      access_epochs(refs, num_refs);
+      return;
+   }
+
+   for (size_t i = 0; i < num_refs; i++) {
+      const access_t &ref = refs[i];
+      if (ref.core >= caches_.size()) {
+         FATAL(": Reference issued by unknown core " << ref.core);
+      }
+      if (cores_.empty()) {
+         caches_[ref.core]->Access(ref.addr, ref.op);
+      } else {
+         cores_[ref.core]->Access(ref.addr, ref.op, ref.gap);
+      }
+   }
+   num_accesses_ += num_refs;
+}
+
+/**
+ * @brief Replay a batch in epochs of `quantum` references, in two phases.
+ * First, every core runs its references of the epoch in program order on the thread
+ * that owns it, as long as they are local hits (see Cache::access_local), and stops at
+ * the first one that is not. Then, once the epoch is complete, the bus arbiter replays
+ * the references that are left one at a time, in trace order.
+ * 
+ * A core can thus run ahead and hit on a block that an earlier reference of another core
+ * invalidates later in the same epoch. Epochs end at multiples of the quantum in the
+ * references replayed since the last reset, and an epoch that a batch leaves unfinished
+ * carries over to the next batch. The results thus only depend on the quantum and on the
+ * calls to sync(), never on the threads or on how the trace is cut into batches.
+ * A quantum of 1 is exactly the sequential replay.
+ * 
+ * @param refs 
+ * @param num_refs 
+ */
+void System::access_epochs(const access_t *refs, size_t num_refs) {
+   for (size_t i = 0; i < num_refs; i++) {
+      if (refs[i].core >= caches_.size()) {
+         FATAL(": Reference issued by unknown core " << refs[i].core);
+      }
+   }
+
+   ulong num_threads = workers_ ? workers_->size() : 1;
+   /* A chunk never spans more than the batch, nor more than an epoch */
+   size_t max_chunk = std::min<size_t>(num_refs, config_.quantum);
+   if (deferred_.size() < max_chunk) {
+      deferred_.resize(max_chunk);
+   }
+
+   size_t begin = 0, end = 0;
+   std::function<void(ulong)> run_local = [&](ulong thread) {
+      for (size_t i = begin; i < end; i++) {
+         uint core = refs[i].core;
+         if (core % num_threads != thread) {
+            continue;
+         }
+         bool deferred = blocked_[core] || !(cores_.empty() ? caches_[core]->access_local(refs[i].addr, refs[i].op)
+                                                            : cores_[core]->access_local(refs[i].addr, refs[i].op, refs[i].gap));
+         deferred_[i - begin] = deferred;
+         blocked_[core] |= deferred;
+      }
+   };
+
+   for (begin = 0; begin < num_refs; begin = end) {
+      /* Up to the end of the current epoch, which may have started in an earlier batch */
+      end = std::min(num_refs, begin + config_.quantum - num_accesses_ % config_.quantum);
+
+      if (workers_) {
+         workers_->run(run_local);
+      } else {
+         run_local(0);
+      }
+
+      for (size_t i = begin; i < end; i++) {
+         if (deferred_[i - begin]) {
+            epoch_refs_.push_back(refs[i]);
+         }
+      }
+
+      num_accesses_ += end - begin;
+      if (num_accesses_ % config_.quantum == 0) {
+         finish_epoch();
+      }
+   }
+}
+
+/**
+ * @brief The arbiter orders the transactions of the epoch by their position in the trace
+ */
+void System::finish_epoch() {
+   for (const access_t &ref : epoch_refs_) {
+      if (cores_.empty()) {
+         caches_[ref.core]->Access(ref.addr, ref.op);
+      } else {
+         cores_[ref.core]->Access(ref.addr, ref.op, ref.gap);
+      }
+   }
+   epoch_refs_.clear();
+   std::fill(blocked_.begin(), blocked_.end(), 0);
+}
+
+void System::sync() {
+   if (config_.quantum != 0) {
+      finish_epoch();
+   }
+}
+
+/**
+ * @brief Tear down the current system and build a new one in its place.
+ * The arena is rewound in O(1) and its chunks are reused.
+ * 
+ * @param config 
+ */
+void System::reset(const system_config_t &config) {
+   destroy();
+   arena_.reset();
+
+   config_       = config;
+   num_accesses_ = 0;
+   epoch_refs_.clear();
+   build();
+}
+
+void System::clear_stats() {
+   sync();
+   for (Cache *cache : caches_) {
+      cache->clear_stats();
+   }
+   interconnect_->clear_stats();
+
+   /**
+    * The cycles of the DRAM count from the time the slowest core leaves the warm-up, so that
+    * none of the accesses it counts came earlier. Cores that never accessed memory have no time yet.
+    */
+   if (dram_ != nullptr) {
+      ulong now = ~0UL;
+      for (Cache *cache : caches_) {
+         if (cache->get_time() > 0) {
+            now = std::min(now, cache->get_time());
+         }
+      }
+      dram_->clear_stats((now == ~0UL) ? 0 : now);
+   }
+   for (Core *core : cores_) {
+      core->clear_stats();
+   }
+}
+
+dram_config_t System::get_dram_config(const system_config_t &config) {
+   dram_config_t dram_config;
+   dram_config.num_channels   = config.dram_channels;
+   dram_config.num_banks      = config.dram_banks;
+   dram_config.policy         = config.dram_policy;
+   dram_config.mode           = config.dram_mode;
+   dram_config.block_bytes    = config.block_size;
+   dram_config.cycles_per_ref = config.dram_cycles_per_ref;
+   return dram_config;
+}
+
+core_config_t System::get_core_config(const system_config_t &config) {
+   core_config_t core_config;
+   core_config.ipc             = config.ipc;
+   core_config.num_mshrs       = config.mshrs;
+   core_config.upgrade_latency = config.upgrade_latency;
+   core_config.remote_latency  = config.remote_latency;
+   core_config.memory_latency  = config.memory_latency;
+   return core_config;
+}
+
+void System::set_outcome_stream(OutcomeWriter *outcomes) {
+   outcomes_ = outcomes;
+   for (Cache *cache : caches_) {
+      cache->set_outcome_stream(outcomes_);
+   }
+}
+
+void System::set_num_threads(ulong num_threads) {
+   delete workers_;
+   workers_ = (num_threads > 1) ? new WorkerPool(num_threads) : nullptr;
+}
+
+void System::set_profiler(Profiler *profiler) {
+   profiler_ = profiler;
+   for (Cache *cache : caches_) {
+      cache->set_profiler(profiler_);
+   }
+   interconnect_->set_profiler(profiler_);
+}
+
+system_stats_t System::get_system_stats() const {
+   system_stats_t stats;
+   for (const Cache *cache : caches_) {
+      stats.caches.push_back(cache->get_stats());
+   }
+   for (ulong bank = 0; bank < interconnect_->get_num_banks(); bank++) {
+      stats.banks.push_back(interconnect_->get_bank_stats(bank));
+   }
+   stats.numa = interconnect_->get_numa_stats();
+   if (dram_ != nullptr) {
+      stats.dram = dram_->get_stats();
+   }
+   for (const Core *core : cores_) {
+      stats.cores.push_back(core->get_stats());
+   }
+   return stats;
+}
+
+void System::print_stats(const system_config_t &config, const system_stats_t &stats) {
+   std::stringstream protocol;
+   protocol << config.protocol;
+
+   /* Every cache prints the atomic section if any core issued an atomic or a fence */
+   bool atomics = false;
+   for (const cache_stats_t &cache : stats.caches) {
+      atomics |= (cache.num_atomics > 0 || cache.num_fences > 0);
+   }
+
+   for (uint i = 0; i < stats.caches.size(); i++) {
+      print_cache_stats(i, protocol.str(), stats.caches[i], config.prefetcher != prefetcher_e::None, 
+                        config.victim_entries > 0, config.wb_buffer_entries > 0, atomics);
+   }
+   if (config.num_sockets > 1) {
+      print_numa_stats(config.num_sockets, config.numa, stats.numa);
+   }
+   if (config.dram_channels > 0) {
+      print_dram_stats(get_dram_config(config), stats.dram);
+   }
+   if (config.ipc > 0.0) {
+      print_core_stats(get_core_config(config), stats.cores);
+   }
+}
+
+ulong System::get_bus_interval(const system_config_t &config) {
+   bool timed = config.ipc > 0.0 || (config.dram_channels > 0 && config.dram_mode == dram_mode_e::Timed);
+   return timed ? config.bus_interval : 0;
+}
+
+void System::print_bus_stats(const system_config_t &config, const system_stats_t &stats) {
+   print_bank_stats(stats.banks);
+
+   ulong interval = get_bus_interval(config);
+   if (interval > 0) {
+      bus_stats_t total;
+      for (const bus_stats_t &bank : stats.banks) {
+         total += bank;
+      }
+      print_bus_intervals(config.ipc > 0.0 ? "core cycles" : "memory cycles", interval, total);
+   }
+}
+
+void System::print_alloc_stats() const {
+   printf("============ Allocation statistics ============\n");
+   printf("%-45s %lu\n", "arena allocations:",          arena_.get_num_allocations());
+   printf("%-45s %lu\n", "arena bytes allocated:",      arena_.get_num_bytes());
+   printf("%-45s %lu\n", "arena chunks:",               arena_.get_num_chunks());
+   printf("%-45s %lu\n", "system allocations (chunks):", arena_.get_num_chunk_allocations());
+}
@@ -0,0 +1,218 @@
+#ifndef __SYSTEM_H__
+#define __SYSTEM_H__
+
+#include <vector>
+#include <iostream>
+#include "types.h"
+#include "cache.h"
+#include "interconnect.h"
+#include "arena.h"
+#include "dram.h"
+#include "workers.h"
+#include "core.h"
+
+/**
+ * @brief Configuration of a simulated SMP system.
+ * Every field takes part in the key of the result cache (see result_cache.cc).
+ */
+struct system_config_t {
+   ulong      cache_size{8192};
+   ulong      assoc{8};
+   ulong      block_size{64};
+   ulong      num_processors{4};
+   protocol_e protocol{protocol_e::MSI};
+   storage_e  storage{storage_e::Dense};
+   index_e    set_index{index_e::Modulo};
+
+   /* Sizes used for bus bandwidth accounting. The block size is taken from block_size */
+   ulong      addr_bytes{8};
+   ulong      word_bytes{8};
+
+   /* Number of address-interleaved bus banks */
+   ulong      num_banks{1};
+
+   /* Cores are split into sockets that each have their own buses */
+   ulong      num_sockets{1};
+   numa_e     numa{numa_e::Broadcast};
+   std::vector<ulong> socket_map;    /* Socket of every core, empty for balanced contiguous groups */
+
+   /* Hardware prefetcher of every cache, and how many blocks it fetches per trigger */
+   prefetcher_e prefetcher{prefetcher_e::None};
+   ulong        prefetch_degree{1};
+
+   /* Entries of the victim cache and of the write-back buffer of every cache, 0 to disable */
+   ulong      victim_entries{0};
+   ulong      wb_buffer_entries{0};
+
+   /* DRAM behind the interconnect, memory is not modeled with 0 channels */
+   ulong         dram_channels{0};
+   ulong         dram_banks{8};
+   dram_policy_e dram_policy{dram_policy_e::Open};
+   dram_mode_e   dram_mode{dram_mode_e::Untimed};
+   ulong         dram_cycles_per_ref{4};
+
+   /**
+    * References per epoch of the parallel replay, 0 for the exact sequential replay.
+    * Within an epoch the cores run their local hits ahead of the bus (see System::access_epochs).
+    */
+   ulong      quantum{0};
+
+   /* Timing front end of the cores (see Core), not modeled with an IPC of 0. Latencies are in core cycles */
+   double     ipc{0.0};
+   ulong      mshrs{8};
+   ulong      upgrade_latency{10};
+   ulong      remote_latency{40};
+   ulong      memory_latency{100};
+
+   /* Cycles per interval of the bus bandwidth breakdown, kept only with a timing model (--ipc or --dram-timed) */
+   ulong      bus_interval{10000};
+};
+
+/**
+ * @brief A single memory reference issued by a core
+ */
+struct access_t {
+   uint  core;
+   op_e  op;
+   ulong addr;
+   uint  gap;     /* Other instructions the core ran since its previous reference, for the core timing model */
+};
+
+/**
+ * @brief A snapshot of every counter of a simulated system.
+ * This is all that is needed to print the results of a run.
+ */
+struct system_stats_t {
+   std::vector<cache_stats_t> caches;
+   std::vector<bus_stats_t>   banks;     /* Per bus bank, summed over the sockets */
+   numa_stats_t               numa;
+   dram_stats_t               dram;
+   std::vector<core_stats_t>  cores;     /* Empty without the core timing model */
+};
+
+/**
+ * @brief Entry point of the simulator library.
+ * A System owns the interconnect and one private cache per core, wired together
+ * the same way as the standalone simulator. References are pushed in batches
+ * and the counters can be queried at any point in between.
+ * 
+ * Every object of the simulated system is drawn from a single arena, with the sets
+ * and blocks of the caches, so that reset() can tear down one configuration and build
+ * the next without going back to the system allocator for them. The objects still
+ * keep small buffers of their own on the heap (bus ports and counters, the directory,
+ * DRAM queues, MSHRs, prefetch candidates), which reset() frees and allocates again.
+ * --alloc-stats counts them apart from the arena.
+ */
+class System {
+private:
+   system_config_t config_;
+
+   Arena arena_;
+   Interconnect *interconnect_{nullptr};
+   Dram *dram_{nullptr};
+   std::vector<Cache*> caches_;
+   std::vector<Core*> cores_;             /* Empty without the core timing model */
+
+   ulong num_accesses_{0};
+
+   /* Optional stream of the outcome of every access, shared by the caches */
+   OutcomeWriter *outcomes_{nullptr};
+
+   /* Optional profiler of the simulator itself, shared by the caches and the buses */
+   Profiler *profiler_{nullptr};
+
+   /**
+    * Threads of the parallel replay. Core i belongs to thread i % num_threads.
+    * They do not depend on the configuration, so they survive reset().
+    */
+   WorkerPool *workers_{nullptr};
+   std::vector<uint8_t> deferred_, blocked_;
+
+   /* References of the current epoch left for the bus arbiter, in trace order */
+   std::vector<access_t> epoch_refs_;
+
+   void build();
+   void destroy();
+   void access_epochs(const access_t *refs, size_t num_refs);
+   void finish_epoch();
+
+public:
+   explicit System(const system_config_t &config);
+   ~System();
+
+   System(const System &) = delete;
+   System &operator=(const System &) = delete;
+
+   /* Replay a batch of references in order */
+   void access(const access_t *refs, size_t num_refs);
+   void access(const std::vector<access_t> &refs) { access(refs.data(), refs.size()); }
+
+   /* Replay a single reference */
+   void access(uint core, op_e op, ulong addr, ulong gap = 0) { 
+      if (core >= caches_.size()) {
+         FATAL(": Reference issued by unknown core " << core);
+      }
+      if (config_.quantum != 0) {
+         access_t ref = {core, op, addr, (uint) gap};
+         access_epochs(&ref, 1);
+         return;
+      }
+      if (cores_.empty()) {
+         caches_[core]->Access(addr, op); 
+      } else {
+         cores_[core]->Access(addr, op, gap);
+      }
+      num_accesses_++;
+   }
+
+   /**
+    * With a quantum, the bus arbiter only replays the references of an epoch once the epoch
+    * is complete. Finish the current epoch early, so that every counter accounts for every
+    * reference replayed so far. The next epoch still ends at a multiple of the quantum.
+    */
+   void sync();
+
+   /* Restart every counter but keep the contents of the caches, e.g. after a warm-up. Implies sync() */
+   void clear_stats();
+
+   /* Return to a cold start with the same configuration */
+   void reset() { reset(config_); }
+
+   /* Return to a cold start with a new configuration */
+   void reset(const system_config_t &config);
+
+   /* Record the outcome of every access from now on, or stop with NULL. Survives reset() */
+   void set_outcome_stream(OutcomeWriter *outcomes);
+
+   /* Profile the accesses from now on, or stop with NULL. Survives reset() */
+   void set_profiler(Profiler *profiler);
+
+   /* Threads that replay the epochs with a quantum. The results do not depend on them */
+   void set_num_threads(ulong num_threads);
+
+   const system_config_t &get_config() const  { return config_; }
+   ulong get_num_accesses() const               { return num_accesses_; }
+   cache_stats_t get_stats(uint core) const     { return caches_[core]->get_stats(); }
+   bus_stats_t get_bus_stats() const            { return interconnect_->get_stats(); }
+   const numa_stats_t &get_numa_stats() const   { return interconnect_->get_numa_stats(); }
+   system_stats_t get_system_stats() const;
+
+   void print_stats() const                     { print_stats(config_, get_system_stats()); }
+   void print_bus_stats() const                 { print_bus_stats(config_, get_system_stats()); }
+   void print_alloc_stats() const;
+
+   /* The DRAM that a configuration puts behind the interconnect */
+   static dram_config_t get_dram_config(const system_config_t &config);
+
+   /* The timing front end that a configuration puts in front of every cache */
+   static core_config_t get_core_config(const system_config_t &config);
+
+   /* Print the results of a run from a snapshot, which need not come from a live system */
+   static void print_stats(const system_config_t &config, const system_stats_t &stats);
+   static void print_bus_stats(const system_config_t &config, const system_stats_t &stats);
+
+   /* Cycles per interval of the bus bandwidth breakdown, 0 without a timing model */
+   static ulong get_bus_interval(const system_config_t &config);
+};
+
+#endif /* __SYSTEM_H__ */
@@ -0,0 +1,165 @@
+#include "tag_match.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HAVE_X86_KERNELS
+#endif
+
+/**
+ * Without AVX2, the SSE4.1 kernel only beats the scalar loop on wide sets
+ * (see tools/bench_tag_match): at 32 ways it was measured 30% slower.
+ */
+#define SSE_MIN_ASSOC 64
+
+static long tag_match_scalar(const ulong *tags, ulong assoc, ulong tag) {
+    for (ulong j = 0; j < assoc; j++) {
+        if (tags[j] == tag) {
+            return j;
+        }
+    }
+    return -1;
+}
+
+#ifdef HAVE_X86_KERNELS
+
+/**
+ * @brief Compare two ways per instruction. 
+ * Any leftover way (odd associativity) is compared with the scalar loop.
+ */
+__attribute__((target("sse4.1")))
+static long tag_match_sse(const ulong *tags, ulong assoc, ulong tag) {
+    const __m128i key = _mm_set1_epi64x(tag);
+    ulong j = 0;
+    for (; j + 2 <= assoc; j += 2) {
+        __m128i ways = _mm_loadu_si128((const __m128i *) &tags[j]);
+        int mask = _mm_movemask_pd(_mm_castsi128_pd(_mm_cmpeq_epi64(ways, key)));
+        if (mask) {
+            return j + __builtin_ctz(mask);
+        }
+    }
+    long way = tag_match_scalar(&tags[j], assoc - j, tag);
+    return (way < 0) ? -1 : (long) j + way;
+}
+
+/**
+ * @brief Compare eight ways per iteration with two 256 bit compares.
+ */
+__attribute__((target("avx2")))
+static long tag_match_avx2(const ulong *tags, ulong assoc, ulong tag) {
+    const __m256i key = _mm256_set1_epi64x(tag);
+    ulong j = 0;
+    for (; j + 8 <= assoc; j += 8) {
+        __m256i lo = _mm256_cmpeq_epi64(_mm256_loadu_si256((const __m256i *) &tags[j]), key);
+        __m256i hi = _mm256_cmpeq_epi64(_mm256_loadu_si256((const __m256i *) &tags[j + 4]), key);
+        int mask = _mm256_movemask_pd(_mm256_castsi256_pd(lo)) | (_mm256_movemask_pd(_mm256_castsi256_pd(hi)) << 4);
+        if (mask) {
+            return j + __builtin_ctz(mask);
+        }
+    }
+    for (; j + 4 <= assoc; j += 4) {
+        __m256i eq = _mm256_cmpeq_epi64(_mm256_loadu_si256((const __m256i *) &tags[j]), key);
+        int mask = _mm256_movemask_pd(_mm256_castsi256_pd(eq));
+        if (mask) {
+            return j + __builtin_ctz(mask);
+        }
+    }
+    long way = tag_match_scalar(&tags[j], assoc - j, tag);
+    return (way < 0) ? -1 : (long) j + way;
+}
+
+/**
+ * @brief AVX2 kernel for a fixed associativity (a multiple of 4).
+ * The loop has a compile-time trip count, so it is fully unrolled
+ * and the masks of all the ways are combined before a single branch.
+ */
+template <ulong ASSOC>
+__attribute__((target("avx2")))
+static long tag_match_avx2_fixed(const ulong *tags, ulong, ulong tag) {
+    static_assert(ASSOC % 4 == 0 && ASSOC <= 32, "Unsupported associativity");
+    const __m256i key = _mm256_set1_epi64x(tag);
+    ulong mask = 0;
+    for (ulong j = 0; j < ASSOC; j += 4) {
+        __m256i eq = _mm256_cmpeq_epi64(_mm256_loadu_si256((const __m256i *) &tags[j]), key);
+        mask |= (ulong) _mm256_movemask_pd(_mm256_castsi256_pd(eq)) << j;
+    }
+    return mask ? (long) __builtin_ctzl(mask) : -1;
+}
+
+#endif /* HAVE_X86_KERNELS */
+
+/**
+ * @brief Scalar kernel for a fixed associativity, unrolled by the compiler
+ */
+template <ulong ASSOC>
+static long tag_match_scalar_fixed(const ulong *tags, ulong, ulong tag) {
+    for (ulong j = 0; j < ASSOC; j++) {
+        if (tags[j] == tag) {
+            return j;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief Pick a kernel specialized for `assoc` when there is one, and the generic kernel otherwise
+ */
+tag_match_fn_t select_tag_match(ulong assoc) {
+#ifdef HAVE_X86_KERNELS
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        switch (assoc) {
+            case 4  : return tag_match_avx2_fixed<4>;
+            case 8  : return tag_match_avx2_fixed<8>;
+            case 16 : return tag_match_avx2_fixed<16>;
+            case 32 : return tag_match_avx2_fixed<32>;
+        }
+        return select_tag_match();
+    }
+#endif
+    switch (assoc) {
+        case 1  : return tag_match_scalar_fixed<1>;
+        case 2  : return tag_match_scalar_fixed<2>;
+        case 4  : return tag_match_scalar_fixed<4>;
+        case 8  : return tag_match_scalar_fixed<8>;
+    }
+#ifdef HAVE_X86_KERNELS
+    if (assoc >= SSE_MIN_ASSOC && __builtin_cpu_supports("sse4.1")) {
+        return tag_match_sse;
+    }
+#endif
+    return tag_match_scalar;
+}
+
+tag_match_fn_t select_tag_match() {
+#ifdef HAVE_X86_KERNELS
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return tag_match_avx2;
+    }
+#endif
+    return tag_match_scalar;
+}
+
+const char *tag_match_name() {
+    tag_match_fn_t fn = select_tag_match();
+#ifdef HAVE_X86_KERNELS
+    if (fn == tag_match_avx2) return "avx2";
+    if (fn == tag_match_sse)  return "sse4.1";
+#endif
+    (void) fn;
+    return "scalar";
+}
+
+std::vector<tag_match_kernel_t> tag_match_kernels() {
+    std::vector<tag_match_kernel_t> kernels = {{"scalar", tag_match_scalar}};
+#ifdef HAVE_X86_KERNELS
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse4.1")) {
+        kernels.push_back({"sse4.1", tag_match_sse});
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        kernels.push_back({"avx2", tag_match_avx2});
+    }
+#endif
+    return kernels;
+}
@@ -0,0 +1,45 @@
+#ifndef __TAG_MATCH_H__
+#define __TAG_MATCH_H__
+
+#include <vector>
+#include "types.h"
+
+/**
+ * @brief Tag stored in the packed tag array for a way that holds no valid block.
+ * A real tag is an address shifted right by the block offset bits, so it can never take this value.
+ */
+#define INVALID_TAG (~0UL)
+
+/**
+ * @brief A tag matching kernel searches the packed tags of one set
+ * and returns the way that holds `tag`, or -1 if there is none.
+ */
+using tag_match_fn_t = long (*)(const ulong *tags, ulong assoc, ulong tag);
+
+/**
+ * @brief Pick the fastest kernel supported by the CPU we are running on (AVX2 or scalar),
+ * for any associativity
+ */
+tag_match_fn_t select_tag_match();
+
+/**
+ * @brief Same as above, but prefer a kernel that is specialized for a fixed associativity,
+ * or SSE4.1 without AVX2 on sets wide enough for it to win
+ */
+tag_match_fn_t select_tag_match(ulong assoc);
+
+/* Name of the kernel returned by select_tag_match(), for reporting */
+const char *tag_match_name();
+
+/**
+ * @brief A generic kernel, by name
+ */
+struct tag_match_kernel_t {
+    const char     *name;
+    tag_match_fn_t  fn;
+};
+
+/* Every generic kernel that the CPU supports, for benchmarks (see tools/bench_tag_match) */
+std::vector<tag_match_kernel_t> tag_match_kernels();
+
+#endif /* __TAG_MATCH_H__ */
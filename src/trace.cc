@@ -0,0 +1,226 @@
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <sys/stat.h>
+#include <iostream>
+#include <algorithm>
+#include "trace.h"
+
+/**
+ * @brief Header of an index file. It is followed by the offsets, the
+ * per-core reference counts and the markers.
+ */
+struct trace_index_header_t {
+   uint32_t magic;
+   uint32_t version;
+   ulong    trace_size, trace_mtime;
+   ulong    interval;
+   ulong    num_refs;
+   ulong    num_offsets, num_cores, num_markers;
+};
+
+bool trace_index_t::load(const std::string &trace) {
+   struct stat st;
+   if (stat(trace.c_str(), &st) != 0) {
+      return false;
+   }
+
+   FILE *file = fopen(path_for(trace).c_str(), "rb");
+   if (!file) {
+      return false;
+   }
+
+   trace_index_header_t header;
+   bool valid = fread(&header, sizeof(header), 1, file) == 1
+             && header.magic == TRACE_INDEX_MAGIC && header.version == TRACE_INDEX_VERSION
+             && header.trace_size == (ulong) st.st_size && header.trace_mtime == (ulong) st.st_mtime;
+
+   if (valid) {
+      trace_size  = header.trace_size;
+      trace_mtime = header.trace_mtime;
+      interval    = header.interval;
+      num_refs    = header.num_refs;
+      offsets.resize(header.num_offsets);
+      core_refs.resize(header.num_cores);
+      markers.resize(header.num_markers);
+
+      valid = fread(offsets.data(), sizeof(ulong), offsets.size(), file) == offsets.size()
+           && fread(core_refs.data(), sizeof(ulong), core_refs.size(), file) == core_refs.size()
+           && fread(markers.data(), sizeof(trace_marker_t), markers.size(), file) == markers.size();
+   }
+   fclose(file);
+   return valid;
+}
+
+bool trace_index_t::save(const std::string &trace) const {
+   FILE *file = fopen(path_for(trace).c_str(), "wb");
+   if (!file) {
+      return false;
+   }
+
+   trace_index_header_t header;
+   memset(&header, 0, sizeof(header));
+   header.magic        = TRACE_INDEX_MAGIC;
+   header.version      = TRACE_INDEX_VERSION;
+   header.trace_size   = trace_size;
+   header.trace_mtime  = trace_mtime;
+   header.interval     = interval;
+   header.num_refs     = num_refs;
+   header.num_offsets  = offsets.size();
+   header.num_cores    = core_refs.size();
+   header.num_markers  = markers.size();
+
+   bool ok = fwrite(&header, sizeof(header), 1, file) == 1
+          && fwrite(offsets.data(), sizeof(ulong), offsets.size(), file) == offsets.size()
+          && fwrite(core_refs.data(), sizeof(ulong), core_refs.size(), file) == core_refs.size()
+          && fwrite(markers.data(), sizeof(trace_marker_t), markers.size(), file) == markers.size();
+   return (fclose(file) == 0) && ok;
+}
+
+ulong trace_index_t::find_marker(record_e kind, ulong from) const {
+   for (const trace_marker_t &marker : markers) {
+      if (marker.kind == kind && marker.ref >= from) {
+         return marker.ref;
+      }
+   }
+   return num_refs;
+}
+
+/******************************************************************/
+
+trace_range_t resolve_window(const trace_window_t &window, const trace_index_t &index) {
+
+   ulong base = 0;
+   ulong top  = index.num_refs;
+
+   if (window.roi) {
+      base = index.find_marker(record_e::RoiBegin);
+      if (base == index.num_refs) {
+         FATAL(": The trace has no ROI begin marker");
+      }
+      top = index.find_marker(record_e::RoiEnd, base);
+   }
+
+   trace_range_t range;
+   range.begin        = std::min(base + window.skip, top);
+   range.end          = window.limit ? std::min(range.begin + window.limit, top) : top;
+   range.warmup_begin = range.begin - std::min(window.warmup, range.begin);
+   return range;
+}
+
+/******************************************************************/
+
+TraceReader::TraceReader(const std::string &path) {
+   file_ = fopen(path.c_str(), "r");
+   if (!file_) {
+      FATAL(": Unable to open trace file " << path);
+   }
+
+   struct stat st;
+   fstat(fileno(file_), &st);
+   size_  = st.st_size;
+   mtime_ = st.st_mtime;
+}
+
+TraceReader::~TraceReader() {
+   fclose(file_);
+}
+
+/**
+ * @brief Read the next record. A record is `<core> <op> <hex address> [<gap>]` on a line of its own.
+ * The op is r, w, a for an atomic read-modify-write, or f for a fence, whose address is ignored.
+ * The optional gap is the number of other instructions the core ran since its previous reference.
+ *
+ * @param record
+ * @return false at the end of the trace
+ */
+bool TraceReader::next(trace_record_t &record) {
+
+   while (fgets(line_, sizeof(line_), file_) != NULL) {
+      offset_ += strlen(line_);
+
+      char *end;
+      ulong core = strtoul(line_, &end, 10);
+      if (end == line_) {
+         continue;  /* Blank line */
+      }
+
+      char *p = end;
+      while (isspace(*p)) {
+         p++;
+      }
+      char op = *p++;
+      ulong addr = strtoul(p, &end, 16);
+      ulong gap  = strtoul(end, NULL, 10);
+
+      if (op == 'b') {
+         record.kind = record_e::RoiBegin;
+      } else if (op == 'e') {
+         record.kind = record_e::RoiEnd;
+      } else {
+         record.kind   = record_e::Access;
+         record.access = {(uint) core, static_cast<op_e>(op), addr, (uint) gap};
+         num_refs_++;
+      }
+      return true;
+   }
+   return false;
+}
+
+void TraceReader::seek(const trace_index_t &index, ulong ref) {
+
+   offset_   = 0;
+   num_refs_ = 0;
+   if (!index.offsets.empty()) {
+      ulong checkpoint = std::min(ref / index.interval, (ulong) index.offsets.size() - 1);
+      offset_   = index.offsets[checkpoint];
+      num_refs_ = checkpoint * index.interval;
+   }
+   fseek(file_, offset_, SEEK_SET);
+
+   /* Read up to the reference from the closest checkpoint */
+   trace_record_t record;
+   while (num_refs_ < ref && next(record)) {}
+}
+
+trace_index_t TraceReader::build_index(ulong interval) {
+
+   fseek(file_, 0, SEEK_SET);
+   offset_   = 0;
+   num_refs_ = 0;
+
+   trace_index_t index;
+   index.trace_size  = size_;
+   index.trace_mtime = mtime_;
+   index.interval    = interval;
+
+   trace_record_t record;
+
+   while (true) {
+      ulong offset = offset_;
+      if (!next(record)) {
+         break;
+      }
+
+      if (record.kind != record_e::Access) {
+         index.markers.push_back({record.kind, num_refs_, offset});
+         continue;
+      }
+
+      /* Checkpoint i is the offset of reference i * interval */
+      if ((num_refs_ - 1) % interval == 0) {
+         index.offsets.push_back(offset);
+      }
+      uint core = record.access.core;
+      if (core >= index.core_refs.size()) {
+         index.core_refs.resize(core + 1, 0);
+      }
+      index.core_refs[core]++;
+   }
+   index.num_refs = num_refs_;
+
+   fseek(file_, 0, SEEK_SET);
+   offset_   = 0;
+   num_refs_ = 0;
+   return index;
+}
@@ -0,0 +1,126 @@
+#ifndef __TRACE_H__
+#define __TRACE_H__
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include "types.h"
+#include "system.h"
+
+#define TRACE_INDEX_MAGIC      0x49504d53UL    /* "SMPI" */
+#define TRACE_INDEX_VERSION    1
+
+/* References between two checkpoints of the index */
+#define TRACE_INDEX_INTERVAL   65536
+
+/**
+ * Kind of a record of a trace. Besides references, a trace may mark the
+ * region of interest with `<core> b 0` and `<core> e 0` records.
+ */
+enum class record_e : uint8_t {
+   Access,
+   RoiBegin,
+   RoiEnd
+};
+
+struct trace_record_t {
+   record_e kind;
+   access_t access;
+};
+
+/**
+ * @brief A marker of the trace and where it is
+ */
+struct trace_marker_t {
+   record_e kind;
+   ulong    ref;        /* Number of references before the marker */
+   ulong    offset;     /* Byte offset of the marker */
+};
+
+/**
+ * @brief Index of a trace: the byte offset of every TRACE_INDEX_INTERVAL-th reference,
+ * the number of references of every core and the markers.
+ * It is kept next to the trace as <trace>.idx, and is only valid for
+ * the size and modification time of the trace it was built from.
+ */
+struct trace_index_t {
+   ulong trace_size{0}, trace_mtime{0};
+   ulong interval{TRACE_INDEX_INTERVAL};
+   ulong num_refs{0};
+   std::vector<ulong> offsets;
+   std::vector<ulong> core_refs;
+   std::vector<trace_marker_t> markers;
+
+   static std::string path_for(const std::string &trace)  { return trace + ".idx"; }
+
+   /* Return false if the trace has no index, or if it changed since the index was built */
+   bool load(const std::string &trace);
+   bool save(const std::string &trace) const;
+
+   /* Position of the first marker of a kind at or after reference `from`, or num_refs if there is none */
+   ulong find_marker(record_e kind, ulong from = 0) const;
+};
+
+/**
+ * @brief The part of a trace to simulate.
+ * With `roi`, skip and limit count from the ROI begin marker, and the run
+ * stops at the ROI end marker. The warm-up references preceding the window
+ * are replayed first to fill the caches, then every counter is cleared.
+ * References are counted over the whole trace, before filtering by core.
+ */
+struct trace_window_t {
+   ulong skip{0};
+   ulong limit{0};              /* 0 for no limit */
+   ulong warmup{0};
+   bool  roi{false};
+   std::vector<ulong> cores;    /* Only replay the references of these cores, all of them if empty */
+
+   bool needs_index() const    { return skip > 0 || warmup > 0 || roi; }
+};
+
+/**
+ * @brief The references [warmup_begin, end) of a trace that a window replays,
+ * of which [begin, end) are measured
+ */
+struct trace_range_t {
+   ulong warmup_begin{0}, begin{0}, end{~0UL};
+};
+
+trace_range_t resolve_window(const trace_window_t &window, const trace_index_t &index);
+
+/**
+ * @brief Reads the records of a text trace one line at a time
+ */
+class TraceReader {
+private:
+   FILE *file_{nullptr};
+   ulong size_{0}, mtime_{0};
+
+   /* Byte offset of the next line, and number of references returned so far */
+   ulong offset_{0};
+   ulong num_refs_{0};
+
+   char line_[256];
+
+public:
+   explicit TraceReader(const std::string &path);
+   ~TraceReader();
+
+   TraceReader(const TraceReader &) = delete;
+   TraceReader &operator=(const TraceReader &) = delete;
+
+   /* Return false at the end of the trace */
+   bool next(trace_record_t &record);
+
+   /* Continue from the `ref`-th reference of the trace */
+   void seek(const trace_index_t &index, ulong ref);
+
+   /* Scan the whole trace. The reader is left at the start of the trace */
+   trace_index_t build_index(ulong interval = TRACE_INDEX_INTERVAL);
+
+   ulong get_num_refs() const  { return num_refs_; }
+   ulong tell() const          { return offset_; }
+   ulong size() const          { return size_; }
+};
+
+#endif /* __TRACE_H__ */
@@ -8,12 +8,67 @@ std::ostream &operator<< (std::ostream &os, const protocol_e &p) {
    return os;
 }
 
+std::ostream &operator<< (std::ostream &os, const storage_e &s) {
+    switch(s) {
+        case storage_e::Dense     : return os << "Dense";
+        case storage_e::Sparse    : return os << "Sparse";
+    }
+   return os;
+}
+
+std::ostream &operator<< (std::ostream &os, const index_e &i) {
+    switch(i) {
+        case index_e::Modulo      : return os << "Modulo";
+        case index_e::XorFold     : return os << "XorFold";
+        case index_e::PrimeModulo : return os << "PrimeModulo";
+        case index_e::Skewed      : return os << "Skewed";
+    }
+    return os;
+}
+
+std::ostream &operator<< (std::ostream &os, const numa_e &n) {
+    switch(n) {
+        case numa_e::Broadcast    : return os << "Broadcast";
+        case numa_e::Directory    : return os << "Directory";
+    }
+   return os;
+}
+
+std::ostream &operator<< (std::ostream &os, const prefetcher_e &p) {
+    switch(p) {
+        case prefetcher_e::None       : return os << "None";
+        case prefetcher_e::NextLine   : return os << "NextLine";
+        case prefetcher_e::Stride     : return os << "Stride";
+        case prefetcher_e::Stream     : return os << "Stream";
+    }
+   return os;
+}
+
+std::ostream &operator<< (std::ostream &os, const dram_policy_e &p) {
+    switch(p) {
+        case dram_policy_e::Open      : return os << "Open";
+        case dram_policy_e::Closed    : return os << "Closed";
+    }
+    return os;
+}
+
+std::ostream &operator<< (std::ostream &os, const dram_mode_e &m) {
+    switch(m) {
+        case dram_mode_e::Untimed     : return os << "Untimed";
+        case dram_mode_e::Timed       : return os << "Timed";
+    }
+    return os;
+}
+
 std::ostream &operator<< (std::ostream &os, const op_e &o) {
     switch(o) {
-        case op_e::PrRd       : return os << "PrRd";
-        case op_e::PrWr       : return os << "PrWr";
-        case op_e::PrRdMiss   : return os << "PrRdMiss";
-        case op_e::PrWrMiss   : return os << "PrWrMiss";
+        case op_e::PrRd         : return os << "PrRd";
+        case op_e::PrWr         : return os << "PrWr";
+        case op_e::PrAtomic     : return os << "PrAtomic";
+        case op_e::PrFence      : return os << "PrFence";
+        case op_e::PrRdMiss     : return os << "PrRdMiss";
+        case op_e::PrWrMiss     : return os << "PrWrMiss";
+        case op_e::PrAtomicMiss : return os << "PrAtomicMiss";
     }
     return os;
 }
@@ -38,6 +93,7 @@ std::ostream &operator<< (std::ostream &os, const bus_signal_e &s) {
         case bus_signal_e::BusUpd   : return os << "BusUpd";
         case bus_signal_e::Flush    : return os << "Flush";
         case bus_signal_e::Update   : return os << "Update";
+        case bus_signal_e::WriteBack: return os << "WriteBack";
    }
    return os;
 }
\ No newline at end of file
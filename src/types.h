@@ -5,6 +5,8 @@
 #include <string>
 #include <sstream>
 #include <vector>
+#include <initializer_list>
+#include <assert.h>
 
 using ulong = unsigned long;
 using uchar = unsigned char;
@@ -15,11 +17,62 @@ enum protocol_e : uint8_t {
    Dragon
 };
 
+/* How the sets of a cache are stored */
+enum class storage_e : uint8_t {
+   Dense,   /* Every set is allocated up front */
+   Sparse   /* A set is allocated the first time a block is filled into it */
+};
+
+/* How the address of a block selects its set */
+enum class index_e : uint8_t {
+   Modulo,        /* The low bits of the block address */
+   XorFold,       /* The block address folded onto the index bits with XOR */
+   PrimeModulo,   /* The block address modulo the largest prime number of sets, the remaining sets are unused */
+   Skewed         /* Every way hashes the block address differently (skewed associativity) */
+};
+
+/* How coherence requests reach the other sockets of a multi-socket system */
+enum class numa_e : uint8_t {
+   Broadcast,  /* Every remote socket snoops every request */
+   Directory   /* The home socket of a block only forwards requests to the sockets that may hold it */
+};
+
+/* Hardware prefetcher attached to each cache */
+enum class prefetcher_e : uint8_t {
+   None,
+   NextLine,   /* Fetch the blocks that follow a miss */
+   Stride,     /* Detect a constant stride per memory region */
+   Stream      /* Detect runs of misses to consecutive blocks and run ahead of them */
+};
+
+/* When the DRAM closes the row buffer of a bank */
+enum class dram_policy_e : uint8_t {
+   Open,       /* Leave the row open for later hits */
+   Closed      /* Precharge after every access */
+};
+
+/* How the DRAM accounts for time */
+enum class dram_mode_e : uint8_t {
+   Untimed,    /* Every access is served on arrival, the latency only depends on the row buffer */
+   Timed       /* Accesses queue per channel and are scheduled FR-FCFS */
+};
+
 enum class op_e : char {
    PrRd = 'r',
    PrWr = 'w',
+   PrAtomic = 'a',      /* Read-modify-write, e.g. test-and-set or CAS. Needs exclusive ownership of the block */
+   PrFence = 'f',       /* Orders the memory operations of a core. Has no address */
    PrRdMiss = 'm',
-   PrWrMiss = 'n'
+   PrWrMiss = 'n',
+   PrAtomicMiss = 'x'
+};
+
+/* Who served an access, which decides its latency in the core timing model */
+enum class service_e : uint8_t {
+   Hit,        /* The cache had the block with the permission it needed */
+   Upgrade,    /* The cache had the block, but needed a bus transaction for the permission */
+   Remote,     /* Another cache supplied the block */
+   Memory      /* Memory supplied the block */
 };
 
 enum class state_e : uint8_t {
@@ -37,32 +90,88 @@ enum class bus_signal_e : uint8_t {
    BusUpd,
    Flush,
    Update,
+   WriteBack,  /* Eviction of a dirty block. Goes to memory, other caches do not snoop it */
 };
 
 std::ostream &operator<< (std::ostream &os, const protocol_e &p);
+std::ostream &operator<< (std::ostream &os, const storage_e &s);
+std::ostream &operator<< (std::ostream &os, const index_e &i);
+std::ostream &operator<< (std::ostream &os, const numa_e &n);
+std::ostream &operator<< (std::ostream &os, const prefetcher_e &p);
+std::ostream &operator<< (std::ostream &os, const dram_policy_e &p);
+std::ostream &operator<< (std::ostream &os, const dram_mode_e &m);
 std::ostream &operator<< (std::ostream &os, const op_e &o);
 std::ostream &operator<< (std::ostream &os, const state_e &s);
 std::ostream &operator<< (std::ostream &os, const bus_signal_e &s);
 
-using bus_signal_t = std::vector<bus_signal_e>;
+/**
+ * @brief The bus signals that result from a state transition, stored inline.
+ * A transition produces at most a couple of signals, so there is no reason
+ * to allocate memory on the heap for every access.
+ */
+class bus_signal_t {
+private:
+   static const uint8_t CAPACITY = 4;
+   bus_signal_e signals_[CAPACITY]{};
+   uint8_t size_{0};
+
+public:
+   bus_signal_t() {}
+   bus_signal_t(std::initializer_list<bus_signal_e> signals) {
+      for (bus_signal_e signal : signals) {
+         push_back(signal);
+      }
+   }
+
+   void push_back(bus_signal_e signal) {
+      assert(size_ < CAPACITY);
+      signals_[size_++] = signal;
+   }
+
+   const bus_signal_e *begin() const   { return signals_; }
+   const bus_signal_e *end() const     { return signals_ + size_; }
+   size_t size() const                 { return size_; }
+   bool empty() const                  { return size_ == 0; }
+};
 
 struct bus_transaction_t {
    bus_transaction_t()
    : processor_id{0}
    , addr{0}
    , copies_exist{false}
+   , num_flushes{0}
+   , num_interventions{0}
+   , num_invalidations{0}
    {}
 
    bus_transaction_t (ulong id_, ulong addr_)
    : processor_id (id_)
    , addr(addr_) 
    , copies_exist{false}
+   , num_flushes{0}
+   , num_interventions{0}
+   , num_invalidations{0}
+   {}
+
+   bus_transaction_t (ulong id_, ulong addr_, const bus_signal_t &signals_)
+   : processor_id (id_)
+   , addr(addr_) 
+   , bus_signals(signals_)
+   , copies_exist{false}
+   , num_flushes{0}
+   , num_interventions{0}
+   , num_invalidations{0}
    {}
 
    ulong        processor_id;  /* ID of the requesting core */
+   ulong        cycle{0};      /* Local time of the requesting core when it issued the transaction */
+   ulong        time{0};       /* The same in the cycles of the timing model, 0 without one (see Cache::local_time) */
    ulong        addr;
    bus_signal_t bus_signals;
    bool         copies_exist;
+   ulong        num_flushes;   /* Number of receiving cores that flushed the block in response */
+   ulong        num_interventions; /* Number of receiving cores that intervened */
+   ulong        num_invalidations; /* Number of receiving cores that lost their copy */
 };
 
 #define FATAL(msg) \
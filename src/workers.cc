@@ -0,0 +1,54 @@
+#include <iostream>
+#include "workers.h"
+
+/* Polls of a shared counter before a waiting thread starts to yield the CPU */
+#define SPIN_LIMIT 4096
+
+/* Wait until `done` holds, spinning first and yielding after */
+template <typename F>
+static void wait_until(F done) {
+    for (ulong spins = 0; !done(); spins++) {
+        if (spins >= SPIN_LIMIT) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+WorkerPool::WorkerPool(ulong num_threads) {
+    if (num_threads == 0) {
+        FATAL(": A worker pool needs at least one thread");
+    }
+    for (ulong id = 1; id < num_threads; id++) {
+        threads_.emplace_back(&WorkerPool::work, this, id);
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    stop_.store(true, std::memory_order_release);
+    generation_.fetch_add(1, std::memory_order_release);
+    for (std::thread &thread : threads_) {
+        thread.join();
+    }
+}
+
+void WorkerPool::work(ulong id) {
+    ulong seen = 0;
+    while (true) {
+        wait_until([&]() { return generation_.load(std::memory_order_acquire) != seen; });
+        seen = generation_.load(std::memory_order_acquire);
+        if (stop_.load(std::memory_order_acquire)) {
+            return;
+        }
+        (*task_)(id);
+        num_pending_.fetch_sub(1, std::memory_order_release);
+    }
+}
+
+void WorkerPool::run(const std::function<void(ulong)> &task) {
+    task_ = &task;
+    num_pending_.store(threads_.size(), std::memory_order_relaxed);
+    generation_.fetch_add(1, std::memory_order_release);
+
+    task(0);
+    wait_until([&]() { return num_pending_.load(std::memory_order_acquire) == 0; });
+}
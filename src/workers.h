@@ -0,0 +1,40 @@
+#ifndef __WORKERS_H__
+#define __WORKERS_H__
+
+#include <atomic>
+#include <functional>
+#include <thread>
+#include <vector>
+#include "types.h"
+
+/**
+ * @brief A fixed set of threads that run the same task together, once per call to run().
+ *
+ * Epochs can be as short as a single reference, so the threads do not sleep between
+ * two tasks: they spin on a generation counter for a while, then yield the CPU.
+ * The calling thread takes part in every task as thread 0.
+ */
+class WorkerPool {
+private:
+    std::vector<std::thread> threads_;
+    std::atomic<ulong> generation_{0};
+    std::atomic<ulong> num_pending_{0};
+    std::atomic<bool>  stop_{false};
+    const std::function<void(ulong)> *task_{nullptr};
+
+    void work(ulong id);
+
+public:
+    explicit WorkerPool(ulong num_threads);
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool &) = delete;
+    WorkerPool &operator=(const WorkerPool &) = delete;
+
+    /* Run task(id) on every thread, and return once all of them are done */
+    void run(const std::function<void(ulong)> &task);
+
+    ulong size() const { return threads_.size() + 1; }
+};
+
+#endif /* __WORKERS_H__ */
@@ -0,0 +1,81 @@
+/*******************************************************
+                    bench_tag_match.cc
+    Time a lookup in the packed tags of a set with every
+    tag matching kernel the CPU supports, and with the
+    kernel that the caches select, by associativity
+********************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <random>
+#include "tag_match.h"
+
+/* Sets to look up in, enough to spill out of the L1 cache of the host like a simulated cache does */
+#define BENCH_SETS      4096
+#define BENCH_LOOKUPS   (2UL << 20)
+
+struct lookup_t {
+    ulong set;
+    ulong tag;
+};
+
+/* Nanoseconds per lookup, the best of a few rounds */
+static double time_kernel(tag_match_fn_t fn, const std::vector<ulong> &tags, ulong assoc, const std::vector<lookup_t> &lookups, long &checksum) {
+    double best = 0.0;
+    for (int round = 0; round < 5; round++) {
+        auto start = std::chrono::steady_clock::now();
+        for (const lookup_t &lookup : lookups) {
+            checksum += fn(&tags[lookup.set * assoc], assoc, lookup.tag);
+        }
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / lookups.size();
+        best = (round == 0 || ns < best) ? ns : best;
+    }
+    return best;
+}
+
+int main(int argc, char *argv[]) {
+
+    /* Share of the lookups that hit, in percent */
+    ulong hit_rate = argc > 1 ? strtoul(argv[1], NULL, 0) : 50;
+    if (hit_rate > 100) {
+        fprintf(stderr, "input format: ./bench_tag_match [hit_rate_percent]\n");
+        exit(EXIT_FAILURE);
+    }
+
+    std::vector<tag_match_kernel_t> kernels = tag_match_kernels();
+    std::mt19937_64 random(1);
+    long checksum = 0;
+
+    printf("ns per lookup, random sets, %lu%% hits, %lu lookups\n", hit_rate, BENCH_LOOKUPS);
+    printf("%-6s", "assoc");
+    for (const tag_match_kernel_t &kernel : kernels) {
+        printf(" %10s", kernel.name);
+    }
+    printf(" %10s\n", "selected");
+
+    for (ulong assoc : {1, 2, 4, 8, 16, 32, 64}) {
+        std::vector<ulong> tags(BENCH_SETS * assoc);
+        for (ulong &tag : tags) {
+            tag = random() >> 8;
+        }
+
+        /* A hit finds the tag of a random way, a miss a tag that no way holds */
+        std::vector<lookup_t> lookups(BENCH_LOOKUPS);
+        for (lookup_t &lookup : lookups) {
+            lookup.set = random() % BENCH_SETS;
+            bool hit   = random() % 100 < hit_rate;
+            lookup.tag = hit ? tags[lookup.set * assoc + random() % assoc] : INVALID_TAG - 1;
+        }
+
+        printf("%-6lu", assoc);
+        for (const tag_match_kernel_t &kernel : kernels) {
+            printf(" %9.2lfn", time_kernel(kernel.fn, tags, assoc, lookups, checksum));
+        }
+        printf(" %9.2lfn\n", time_kernel(select_tag_match(assoc), tags, assoc, lookups, checksum));
+    }
+
+    /* Keeps the lookups from being optimized away */
+    fprintf(stderr, "checksum %ld\n", checksum);
+    return 0;
+}
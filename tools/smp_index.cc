@@ -0,0 +1,46 @@
+/*******************************************************
+                       smp_index.cc
+    Build the index of a trace once, so that runs of
+    smp_cache with --skip, --warmup or --roi can seek
+    into it instead of reading it from the start
+********************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <iostream>
+#include "trace.h"
+
+int main(int argc, char *argv[]) {
+
+    if (argc < 2) {
+        fprintf(stderr, "input format: ./smp_index <trace_file> [interval]\n");
+        exit(EXIT_FAILURE);
+    }
+
+    std::string fname = argv[1];
+    ulong interval = argc > 2 ? strtoul(argv[2], NULL, 0) : TRACE_INDEX_INTERVAL;
+    if (interval == 0) {
+        fprintf(stderr, "ERROR: The interval must be at least 1\n");
+        exit(EXIT_FAILURE);
+    }
+
+    TraceReader trace(fname);
+    trace_index_t index = trace.build_index(interval);
+
+    if (!index.save(fname)) {
+        fprintf(stderr, "ERROR: Unable to write %s\n", trace_index_t::path_for(fname).c_str());
+        exit(EXIT_FAILURE);
+    }
+
+    printf("============ Index of %s ============\n", fname.c_str());
+    printf("%-25s %lu\n", "references:", index.num_refs);
+    printf("%-25s %lu\n", "checkpoints:", (ulong) index.offsets.size());
+    for (ulong core = 0; core < index.core_refs.size(); core++) {
+        printf("core %-20lu %lu\n", core, index.core_refs[core]);
+    }
+    for (const trace_marker_t &marker : index.markers) {
+        printf("%-25s %lu\n", marker.kind == record_e::RoiBegin ? "ROI begin at reference:" : "ROI end at reference:", marker.ref);
+    }
+
+    return 0;
+}
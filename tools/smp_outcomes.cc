@@ -0,0 +1,129 @@
+/*******************************************************
+                      smp_outcomes.cc
+    Aggregate an outcome stream written by smp_cache
+    with --outcomes=<path>
+********************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <iostream>
+#include <iomanip>
+#include <map>
+#include <vector>
+#include "outcome.h"
+
+#define NUM_STATES    6
+#define NUM_SIGNALS   6
+
+/**
+ * @brief Counters rebuilt from the records of one core
+ */
+struct core_outcomes_t {
+    ulong num_reads{0}, num_read_misses{0}, num_writes{0}, num_write_misses{0}, num_atomics{0}, num_atomic_misses{0};
+    ulong num_victim_hits{0}, num_prefetch_hits{0};
+    ulong num_evictions{0}, num_write_backs{0};
+    ulong num_invalidations{0}, num_interventions{0}, num_flushes{0};
+    ulong signals[NUM_SIGNALS]{};
+};
+
+int main(int argc, char *argv[]) {
+
+    if (argc < 2) {
+        fprintf(stderr, "input format: ./smp_outcomes <outcome_stream>\n");
+        exit(EXIT_FAILURE);
+    }
+
+    OutcomeReader reader(argv[1]);
+    const outcome_header_t &header = reader.get_header();
+
+    std::vector<core_outcomes_t> cores(header.num_cores);
+    ulong transitions[NUM_STATES][NUM_STATES]{};
+    ulong num_records = 0;
+
+    outcome_record_t r;
+    while (reader.next(r)) {
+        if (r.core >= cores.size() || r.state_before >= NUM_STATES || r.state_after >= NUM_STATES) {
+            fprintf(stderr, "ERROR: Corrupt record %lu\n", num_records);
+            exit(EXIT_FAILURE);
+        }
+        core_outcomes_t &c = cores[r.core];
+        bool miss = !(r.flags & OUTCOME_HIT);
+
+        if (r.op == static_cast<uint8_t>(op_e::PrRd)) {
+            c.num_reads++;
+            c.num_read_misses += miss;
+        } else if (r.op == static_cast<uint8_t>(op_e::PrWr)) {
+            c.num_writes++;
+            c.num_write_misses += miss;
+        } else if (r.op == static_cast<uint8_t>(op_e::PrAtomic)) {
+            c.num_atomics++;
+            c.num_atomic_misses += miss;
+        }
+        c.num_victim_hits     += (r.flags & OUTCOME_VICTIM_HIT) != 0;
+        c.num_prefetch_hits   += (r.flags & OUTCOME_PREFETCH_HIT) != 0;
+        c.num_evictions       += (r.flags & OUTCOME_EVICTION) != 0;
+        c.num_write_backs     += (r.flags & OUTCOME_WRITE_BACK) != 0;
+        c.num_invalidations   += r.num_invalidations;
+        c.num_interventions   += r.num_interventions;
+        c.num_flushes         += r.num_flushes;
+
+        for (uint s = 0; s < NUM_SIGNALS; s++) {
+            c.signals[s] += (r.signals >> s) & 1;
+        }
+        transitions[r.state_before][r.state_after]++;
+        num_records++;
+    }
+
+    std::cout << "============ Outcome stream: " << num_records << " references, "
+              << header.num_cores << " cores, " << static_cast<protocol_e>(header.protocol)
+              << ", " << header.block_size << "B blocks ============\n";
+
+    printf("%-28s", "");
+    for (ulong i = 0; i < cores.size(); i++) {
+        printf(" %10s%-2lu", "core ", i);
+    }
+    printf("\n");
+
+#define TRACE_ROW(s, field) \
+    do { \
+        printf("%-28s", s); \
+        for (const core_outcomes_t &c : cores) printf(" %12lu", c.field); \
+        printf("\n"); \
+    } while(0)
+
+    TRACE_ROW("reads:",                   num_reads);
+    TRACE_ROW("read misses:",             num_read_misses);
+    TRACE_ROW("writes:",                  num_writes);
+    TRACE_ROW("write misses:",            num_write_misses);
+    TRACE_ROW("atomics:",                 num_atomics);
+    TRACE_ROW("atomic misses:",           num_atomic_misses);
+    TRACE_ROW("victim cache hits:",       num_victim_hits);
+    TRACE_ROW("first prefetched hits:",   num_prefetch_hits);
+    TRACE_ROW("evictions:",               num_evictions);
+    TRACE_ROW("dirty evictions:",         num_write_backs);
+    TRACE_ROW("invalidations caused:",    num_invalidations);
+    TRACE_ROW("interventions caused:",    num_interventions);
+    TRACE_ROW("flushes caused:",          num_flushes);
+
+    for (uint s = 0; s < NUM_SIGNALS; s++) {
+        std::stringstream name;
+        name << static_cast<bus_signal_e>(s) << " issued:";
+        printf("%-28s", name.str().c_str());
+        for (const core_outcomes_t &c : cores) printf(" %12lu", c.signals[s]);
+        printf("\n");
+    }
+
+    printf("============ State transitions (all cores) ============\n");
+    for (uint from = 0; from < NUM_STATES; from++) {
+        for (uint to = 0; to < NUM_STATES; to++) {
+            if (transitions[from][to] == 0) {
+                continue;
+            }
+            std::stringstream name;
+            name << static_cast<state_e>(from) << " -> " << static_cast<state_e>(to);
+            printf("%-36s %12lu\n", name.str().c_str(), transitions[from][to]);
+        }
+    }
+
+    return 0;
+}
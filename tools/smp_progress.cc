@@ -0,0 +1,64 @@
+/*******************************************************
+                      smp_progress.cc
+    Print the live progress of a run of smp_cache that
+    was started with --progress=<path>
+********************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string>
+#include "progress.h"
+
+static void print_progress(const progress_snapshot_t &s) {
+    printf("references:        %lu%s\n", s.num_refs, s.done ? " (done)" : "");
+    if (s.num_warmup_refs) {
+        printf("  of which warm-up:  %lu (not in the counters)\n", s.num_warmup_refs);
+    }
+    printf("elapsed:           %.1lf s\n", s.elapsed());
+    printf("references/s:      %.0lf\n", s.refs_per_second());
+    if (!s.done) {
+        printf("trace read:        %.1lf%%\n", s.trace_bytes ? 100.0 * s.trace_bytes_read / s.trace_bytes : 0.0);
+        printf("ETA:               %.1lf s\n", s.eta());
+    }
+
+    printf("%-6s %12s %12s %12s %12s %12s %12s %12s\n",
+           "cache", "reads", "rd misses", "writes", "wr misses", "miss rate", "writebacks", "flushes");
+    for (ulong i = 0; i < s.caches.size(); i++) {
+        const cache_stats_t &c = s.caches[i];
+        printf("%-6lu %12lu %12lu %12lu %12lu %11.2lf%% %12lu %12lu\n", i,
+               c.num_reads, c.num_read_misses, c.num_writes, c.num_write_misses,
+               c.miss_rate(), c.num_write_backs, c.coherence.num_flushes);
+    }
+}
+
+int main(int argc, char *argv[]) {
+
+    if (argc < 2) {
+        fprintf(stderr, "input format: ./smp_progress <progress_page> [interval_seconds]\n");
+        exit(EXIT_FAILURE);
+    }
+
+    const progress_page_t *page = open_progress(argv[1]);
+    if (page == NULL) {
+        fprintf(stderr, "ERROR: %s is not a progress page\n", argv[1]);
+        exit(EXIT_FAILURE);
+    }
+
+    /* Without an interval print a single snapshot, otherwise follow the run until it is done */
+    ulong interval = argc > 2 ? strtoul(argv[2], NULL, 0) : 0;
+    progress_snapshot_t snapshot;
+
+    while (true) {
+        read_progress(page, snapshot);
+        print_progress(snapshot);
+        if (interval == 0 || snapshot.done) {
+            break;
+        }
+        printf("\n");
+        fflush(stdout);
+        sleep(interval);
+    }
+
+    return 0;
+}